@@ -0,0 +1,38 @@
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "Ds4Benchmark.h"
+
+/**
+ * \brief Runs the mapping engine benchmark and writes its results to stdout.
+ * usage: ds4wizard-benchmark [capture file]
+ * If a capture file is given, its reports are replayed in place of generated ones.
+ */
+int main(int argc, char** argv)
+{
+	std::vector<Ds4BenchmarkResult> results;
+
+	try
+	{
+		std::unique_ptr<Ds4CaptureReader> capture;
+
+		if (argc > 1)
+		{
+			capture = std::make_unique<Ds4CaptureReader>(argv[1]);
+		}
+
+		for (const Ds4BenchmarkScenario& scenario : Ds4Benchmark::defaultScenarios())
+		{
+			results.push_back(capture ? Ds4Benchmark::run(scenario, capture->records()) : Ds4Benchmark::run(scenario));
+		}
+	}
+	catch (const std::exception& ex)
+	{
+		std::cerr << ex.what() << std::endl;
+		return 1;
+	}
+
+	Ds4Benchmark::print(std::cout, results);
+	return 0;
+}
@@ -169,13 +169,15 @@ void InputAxisOptions::writeJson(nlohmann::json& json) const
 	}
 }
 
-AxisOptions XInputAxes::getAxisOptions(XInputAxis::T axis) const
+const AxisOptions& XInputAxes::getAxisOptions(XInputAxis::T axis) const
 {
+	static const AxisOptions defaultOptions;
+
 	const auto it = options.find(axis);
 
 	if (it == options.end())
 	{
-		return AxisOptions();
+		return defaultOptions;
 	}
 
 	return it->second;
@@ -231,13 +233,15 @@ void XInputAxes::writeJson(nlohmann::json& json) const
 	}
 }
 
-AxisOptions MouseAxes::getAxisOptions(Direction_t axis)
+const AxisOptions& MouseAxes::getAxisOptions(Direction_t axis) const
 {
+	static const AxisOptions defaultOptions;
+
 	const auto it = options.find(axis);
 
 	if (it == options.end())
 	{
-		return AxisOptions();
+		return defaultOptions;
 	}
 
 	return it->second;
@@ -252,11 +256,11 @@ bool MouseAxes::operator==(const MouseAxes& other) const
 void MouseAxes::readJson(const nlohmann::json& /*json*/)
 {
 	// TODO: not implemented
-	throw std::runtime_error(__FUNCTION__ " not implemented");
+	throw std::runtime_error(std::string(__FUNCTION__) + " not implemented");
 }
 
 void MouseAxes::writeJson(nlohmann::json& /*json*/) const
 {
 	// TODO: not implemented
-	throw std::runtime_error(__FUNCTION__ " not implemented");
+	throw std::runtime_error(std::string(__FUNCTION__) + " not implemented");
 }
@@ -161,7 +161,7 @@ public:
 	 * \param axis The axis to retrieve the configuration for.
 	 * \return The configuration for the requested axis, or empty configuration if not found.
 	 */
-	[[nodiscard]] AxisOptions getAxisOptions(XInputAxis::T axis) const;
+	[[nodiscard]] const AxisOptions& getAxisOptions(XInputAxis::T axis) const;
 
 	bool operator==(const XInputAxes& other) const;
 	bool operator!=(const XInputAxes& other) const;
@@ -194,7 +194,7 @@ public:
 	 * \param axis The axis to retrieve the configuration for.
 	 * \return The configuration for the requested axis, or empty configuration if not found.
 	 */
-	AxisOptions getAxisOptions(Direction_t axis);
+	[[nodiscard]] const AxisOptions& getAxisOptions(Direction_t axis) const;
 
 	bool operator==(const MouseAxes& other) const;
 	void readJson(const nlohmann::json& json) override;
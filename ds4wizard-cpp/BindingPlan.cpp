@@ -0,0 +1,433 @@
+#include "pch.h"
+
+#include <algorithm>
+
+#include "BindingPlan.h"
+#include "DeviceProfile.h"
+#include "Ds4Input.h"
+
+namespace
+{
+	/**
+	 * \brief Sort keys for each kind of input source. Buttons sort before axes, which sort before touch regions.
+	 */
+	constexpr size_t buttonOrder = 0;
+	constexpr size_t axisOrder   = buttonOrder + Ds4Buttons_values.size();
+	constexpr size_t touchOrder  = axisOrder + Ds4Axes_values.size();
+
+	template <typename T, size_t N>
+	size_t firstBitOrder(const std::array<T, N>& values, T bits)
+	{
+		const auto it = std::ranges::find_if(values, [bits](T bit) { return !!(bits & bit); });
+		return static_cast<size_t>(std::distance(values.begin(), it));
+	}
+
+	size_t sourceOrder(const BindingPlanSource& source, const Ds4TouchRegionCache& touchRegions)
+	{
+		if (source.buttons != 0)
+		{
+			return buttonOrder + firstBitOrder(Ds4Buttons_values, source.buttons);
+		}
+
+		if (source.axes != 0)
+		{
+			return axisOrder + firstBitOrder(Ds4Axes_values, source.axes);
+		}
+
+		return touchOrder + (source.touchRegion != nullptr ? source.touchRegionId : touchRegions.size());
+	}
+
+	template <typename Op>
+	void sortBySource(std::vector<Op>& ops, const Ds4TouchRegionCache& touchRegions)
+	{
+		std::vector<std::pair<size_t, Op>> keyed;
+		keyed.reserve(ops.size());
+
+		for (Op& op : ops)
+		{
+			keyed.emplace_back(sourceOrder(op.source, touchRegions), std::move(op));
+		}
+
+		std::ranges::stable_sort(keyed, {}, &std::pair<size_t, Op>::first);
+
+		ops.clear();
+
+		for (auto& pair : keyed)
+		{
+			ops.emplace_back(std::move(pair.second));
+		}
+	}
+
+	void addUnique(std::vector<uint32_t>& ops, uint32_t op)
+	{
+		// ops are always added in ascending order, so a duplicate can only be the last element
+		if (ops.empty() || ops.back() != op)
+		{
+			ops.push_back(op);
+		}
+	}
+}
+
+void BindingPlanOpSet::resize(size_t count)
+{
+	words.assign((count + 63) / 64, 0);
+}
+
+void BindingPlanOpSet::clear()
+{
+	std::ranges::fill(words, 0);
+}
+
+void BindingPlanOpSet::insert(uint32_t op)
+{
+	words[op / 64] |= 1ull << (op % 64);
+}
+
+void BindingPlanOpSet::insertAll(size_t count)
+{
+	const size_t full = count / 64;
+
+	std::fill_n(words.begin(), full, ~0ull);
+
+	if (count % 64)
+	{
+		words[full] |= (1ull << (count % 64)) - 1;
+	}
+}
+
+void BindingPlanOpSet::assign(const BindingPlanOpSet& other)
+{
+	std::ranges::copy(other.words, words.begin());
+}
+
+void BindingPlanIndex::clear()
+{
+	for (auto& ops : buttons)
+	{
+		ops.clear();
+	}
+
+	for (auto& ops : axes)
+	{
+		ops.clear();
+	}
+
+	touch.clear();
+	always.clear();
+}
+
+void BindingPlanIndex::add(uint32_t op, const BindingPlanSource& source)
+{
+	for (size_t i = 0; i < Ds4Buttons_values.size(); ++i)
+	{
+		if (source.buttons & Ds4Buttons_values[i])
+		{
+			addUnique(buttons[i], op);
+		}
+	}
+
+	for (const Ds4Axes_t bit : Ds4Axes_values)
+	{
+		if (source.axes & bit)
+		{
+			addUnique(axes[Ds4Input::axisIndex(bit)], op);
+		}
+	}
+
+	if (source.touchRegion != nullptr)
+	{
+		addUnique(touch, op);
+	}
+
+	// a trigger can only change state when one of its buttons is pressed or released, unless it is timed
+	for (size_t i = 0; i < Ds4Buttons_values.size(); ++i)
+	{
+		if (source.triggerButtons & Ds4Buttons_values[i])
+		{
+			addUnique(buttons[i], op);
+		}
+	}
+}
+
+void BindingPlanIndex::collect(Ds4Buttons_t changedButtons, Ds4Axes_t changedAxes, bool touchChanged, BindingPlanOpSet& out) const
+{
+	auto insert = [&](const std::vector<uint32_t>& ops)
+	{
+		for (const uint32_t op : ops)
+		{
+			out.insert(op);
+		}
+	};
+
+	if (changedButtons != 0)
+	{
+		for (size_t i = 0; i < Ds4Buttons_values.size(); ++i)
+		{
+			if (changedButtons & Ds4Buttons_values[i])
+			{
+				insert(buttons[i]);
+			}
+		}
+	}
+
+	if (changedAxes != 0)
+	{
+		for (const Ds4Axes_t bit : Ds4Axes_values)
+		{
+			if (changedAxes & bit)
+			{
+				insert(axes[Ds4Input::axisIndex(bit)]);
+			}
+		}
+	}
+
+	if (touchChanged)
+	{
+		insert(touch);
+	}
+
+	insert(always);
+}
+
+void BindingPlanSuppression::reset(size_t touchRegionCount)
+{
+	const size_t words = (touchRegionCount + 63) / 64;
+
+	buttons = 0;
+	axes    = 0;
+	touchRegions.assign(words, 0);
+
+	sharedButtons = 0;
+	sharedAxes    = 0;
+	sharedTouchRegions.assign(words, 0);
+}
+
+void BindingPlanSuppression::add(const BindingPlanSource& source)
+{
+	sharedButtons |= buttons & source.buttons;
+	buttons       |= source.buttons;
+
+	sharedAxes |= axes & source.axes;
+	axes       |= source.axes;
+
+	if (source.touchRegion != nullptr)
+	{
+		const size_t word  = source.touchRegionId / 64;
+		const uint64_t bit = 1ull << (source.touchRegionId % 64);
+
+		sharedTouchRegions[word] |= touchRegions[word] & bit;
+		touchRegions[word]       |= bit;
+	}
+}
+
+bool BindingPlanSuppression::suppresses(const BindingPlanSource& source, bool claimsItself) const
+{
+	const Ds4Buttons_t claimedButtons = claimsItself ? sharedButtons : buttons;
+	const Ds4Axes_t claimedAxes       = claimsItself ? sharedAxes : axes;
+
+	if ((source.buttons & claimedButtons) || (source.axes & claimedAxes))
+	{
+		return true;
+	}
+
+	if (source.touchRegion == nullptr)
+	{
+		return false;
+	}
+
+	const auto& claimedTouchRegions = claimsItself ? sharedTouchRegions : touchRegions;
+	return !!(claimedTouchRegions[source.touchRegionId / 64] & (1ull << (source.touchRegionId % 64)));
+}
+
+void BindingPlan::compile(DeviceProfile& profile, const Ds4TouchRegionCache& touchRegions)
+{
+	clear();
+
+	touchRegionCount = touchRegions.size();
+
+	for (InputMap& map : profile.bindings)
+	{
+		BindingPlanOp op;
+
+		if (resolveSource(map, touchRegions, op.source))
+		{
+			op.map = &map;
+			bindings.emplace_back(std::move(op));
+		}
+	}
+
+	for (InputModifier& modifier : profile.modifiers)
+	{
+		ModifierPlanOp op;
+
+		if (!resolveSource(modifier, touchRegions, op.source))
+		{
+			continue;
+		}
+
+		op.modifier     = &modifier;
+		op.firstBinding = static_cast<uint32_t>(modifierBindings.size());
+
+		// every binding of the modifier is evaluated along with it, even if it has no valid input source
+		for (InputMap& map : modifier.bindings)
+		{
+			BindingPlanOp bindingOp;
+			resolveSource(map, touchRegions, bindingOp.source);
+
+			bindingOp.map      = &map;
+			bindingOp.modifier = &modifier;
+
+			modifierBindings.emplace_back(std::move(bindingOp));
+		}
+
+		op.bindingCount = static_cast<uint32_t>(modifierBindings.size()) - op.firstBinding;
+		modifiers.emplace_back(std::move(op));
+	}
+
+	sortBySource(bindings, touchRegions);
+	sortBySource(modifiers, touchRegions);
+
+	buildIndices();
+}
+
+void BindingPlan::clear()
+{
+	modifiers.clear();
+	bindings.clear();
+	modifierBindings.clear();
+	axes.clear();
+	modifierIndex.clear();
+	bindingIndex.clear();
+	touchRegionCount = 0;
+	triggers.clear();
+}
+
+std::span<const BindingPlanOp> BindingPlan::getBindings(const ModifierPlanOp& modifier) const
+{
+	return std::span(modifierBindings).subspan(modifier.firstBinding, modifier.bindingCount);
+}
+
+std::span<const BindingPlanAxis> BindingPlan::getAxes(const BindingPlanSource& source) const
+{
+	return std::span(axes).subspan(source.firstAxis, source.axisCount);
+}
+
+bool BindingPlan::resolveSource(const InputMapBase& map, const Ds4TouchRegionCache& touchRegions, BindingPlanSource& source)
+{
+	bool valid = false;
+
+	source.inputType = map.inputType;
+	source.firstAxis = static_cast<uint32_t>(axes.size());
+
+	if (map.inputType & InputType::button)
+	{
+		source.buttons = map.inputButtons.value_or(0);
+		valid = valid || source.buttons != 0;
+	}
+
+	if (map.inputType & InputType::axis)
+	{
+		source.axes = map.inputAxes.value_or(0);
+
+		for (const Ds4Axes_t bit : Ds4Axes_values)
+		{
+			if (source.axes & bit)
+			{
+				axes.push_back({ bit, Ds4Input::axisIndex(bit), map.getAxisOptions(bit) });
+			}
+		}
+
+		valid = valid || source.axes != 0;
+	}
+
+	source.axisCount = static_cast<uint32_t>(axes.size()) - source.firstAxis;
+
+	if (map.inputType & InputType::touchRegion && !map.inputTouchRegion.empty())
+	{
+		const auto it = touchRegions.find(map.inputTouchRegion);
+
+		if (it != touchRegions.end())
+		{
+			source.touchRegion   = it->second;
+			source.touchRegionId = static_cast<uint32_t>(std::distance(touchRegions.begin(), it));
+			valid = true;
+		}
+
+		source.touchDirection = map.inputTouchDirection.value_or(Direction::none);
+	}
+
+	if (map.inputType & InputType::trigger && map.inputTrigger.has_value())
+	{
+		const std::optional<uint32_t> id = triggers.add(*map.inputTrigger);
+
+		if (id.has_value())
+		{
+			source.triggerButtons = map.inputTrigger->buttons();
+			source.triggerId      = *id;
+			valid = true;
+		}
+	}
+
+	return valid;
+}
+
+bool BindingPlan::isContinuous(const BindingPlanOp& op) const
+{
+	const InputMap& map = *op.map;
+
+	if (map.isPersistent())
+	{
+		return true;
+	}
+
+	// taps and holds change state as time passes
+	if (op.source.triggerButtons != 0 && triggers.isTimed(op.source.triggerId))
+	{
+		return true;
+	}
+
+	// analog outputs are re-applied every tick even if their input has not changed
+	if (map.simulatorType == +SimulatorType::input && (map.xinputAxes.has_value() || map.mouseAxes.has_value()))
+	{
+		return true;
+	}
+
+	// sticks and trackballs produce output from their own state, e.g. a trackball that is still rolling
+	return op.source.touchRegion != nullptr && op.source.touchRegion->type != +Ds4TouchRegionType::button;
+}
+
+void BindingPlan::buildIndices()
+{
+	for (uint32_t i = 0; i < static_cast<uint32_t>(bindings.size()); ++i)
+	{
+		const BindingPlanOp& op = bindings[i];
+
+		bindingIndex.add(i, op.source);
+
+		if (isContinuous(op))
+		{
+			bindingIndex.always.push_back(i);
+		}
+	}
+
+	for (uint32_t i = 0; i < static_cast<uint32_t>(modifiers.size()); ++i)
+	{
+		const ModifierPlanOp& op = modifiers[i];
+
+		modifierIndex.add(i, op.source);
+
+		bool continuous = op.modifier->isPersistent() ||
+		                  (op.source.triggerButtons != 0 && triggers.isTimed(op.source.triggerId));
+
+		for (const BindingPlanOp& bindingOp : getBindings(op))
+		{
+			modifierIndex.add(i, bindingOp.source);
+			continuous = continuous || isContinuous(bindingOp);
+		}
+
+		if (continuous)
+		{
+			modifierIndex.always.push_back(i);
+		}
+	}
+}
@@ -0,0 +1,333 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <span>
+#include <tuple>
+#include <vector>
+
+#include "enums.h"
+#include "InputMap.h"
+#include "Ds4Input.h"
+#include "Ds4TouchRegion.h"
+#include "InputTrigger.h"
+
+class DeviceProfile;
+
+/**
+ * \brief An input axis of a binding with its options resolved at compile time.
+ * \sa BindingPlanSource
+ */
+struct BindingPlanAxis
+{
+	/**
+	 * \brief The single \c Ds4Axes bit this entry refers to.
+	 */
+	Ds4Axes_t axis = 0;
+
+	/**
+	 * \brief The index of \c axis within \c Ds4Input::getAllAxes.
+	 */
+	size_t index = 0;
+
+	InputAxisOptions options;
+};
+
+/**
+ * \brief The input sources of a binding or modifier, resolved from its \c InputMapBase.
+ */
+struct BindingPlanSource
+{
+	InputType_t inputType = 0;
+
+	/**
+	 * \brief Buttons which must all be held, or \c 0 if \c inputType does not include \c InputType::button.
+	 */
+	Ds4Buttons_t buttons = 0;
+
+	/**
+	 * \brief Axes which must all be past their dead zone, or \c 0 if \c inputType does not include \c InputType::axis.
+	 */
+	Ds4Axes_t axes = 0;
+
+	/**
+	 * \brief Range of \c BindingPlan::axes containing the resolved options of each bit in \c axes.
+	 */
+	uint32_t firstAxis = 0;
+	uint32_t axisCount = 0;
+
+	/**
+	 * \brief The touch region, or \c nullptr if \c inputType does not include \c InputType::touchRegion
+	 * or the region does not exist in the profile.
+	 */
+	Ds4TouchRegion* touchRegion = nullptr;
+	Direction_t touchDirection = Direction::none;
+
+	/**
+	 * \brief The index of \c touchRegion among the profile's touch regions, ordered by name.
+	 */
+	uint32_t touchRegionId = 0;
+
+	/**
+	 * \brief Every button of the trigger, or \c 0 if \c inputType does not include \c InputType::trigger
+	 * or the trigger is not valid.
+	 */
+	Ds4Buttons_t triggerButtons = 0;
+
+	/**
+	 * \brief The ID of the trigger within \c BindingPlan::triggers.
+	 */
+	uint32_t triggerId = 0;
+};
+
+/**
+ * \brief A binding to be evaluated by the plan, with its parent modifier if any.
+ */
+struct BindingPlanOp
+{
+	BindingPlanSource source;
+	InputMap* map = nullptr;
+	InputModifier* modifier = nullptr;
+};
+
+/**
+ * \brief A modifier set to be evaluated by the plan, along with the range of its bindings.
+ */
+struct ModifierPlanOp
+{
+	BindingPlanSource source;
+	InputModifier* modifier = nullptr;
+
+	/**
+	 * \brief Range of \c BindingPlan::modifierBindings containing the bindings of \c modifier.
+	 */
+	uint32_t firstBinding = 0;
+	uint32_t bindingCount = 0;
+};
+
+/**
+ * \brief A set of plan ops, stored as a dense bitset indexed by op and iterated in plan order.
+ * Once sized, inserting, clearing and copying never allocate.
+ */
+class BindingPlanOpSet
+{
+	std::vector<uint64_t> words;
+
+public:
+	/**
+	 * \brief Sizes the set for a number of ops and clears it.
+	 */
+	void resize(size_t count);
+
+	/**
+	 * \brief Removes every op from the set.
+	 */
+	void clear();
+
+	/**
+	 * \brief Adds an op to the set. Adding an op more than once has no effect.
+	 */
+	void insert(uint32_t op);
+
+	/**
+	 * \brief Adds the first \p count ops of a plan array to the set.
+	 */
+	void insertAll(size_t count);
+
+	/**
+	 * \brief Replaces the contents of this set with those of another set of the same size.
+	 */
+	void assign(const BindingPlanOpSet& other);
+
+	/**
+	 * \brief Invokes \p callback with each op in the set, in ascending order.
+	 */
+	template <typename Callback>
+	void forEach(Callback&& callback) const
+	{
+		for (size_t i = 0; i < words.size(); ++i)
+		{
+			for (uint64_t word = words[i]; word != 0; word &= word - 1)
+			{
+				callback(static_cast<uint32_t>(i * 64 + std::countr_zero(word)));
+			}
+		}
+	}
+};
+
+/**
+ * \brief Indices of plan ops by the input sources they depend on, used to evaluate only the ops affected by a change.
+ * \sa BindingPlan::modifierIndex, BindingPlan::bindingIndex
+ */
+struct BindingPlanIndex
+{
+	/**
+	 * \brief Ops depending on each button, in the order of \c Ds4Buttons_values.
+	 */
+	std::array<std::vector<uint32_t>, std::tuple_size_v<decltype(Ds4Buttons_values)>> buttons;
+
+	/**
+	 * \brief Ops depending on each axis, indexed by \c Ds4Input::axisIndex.
+	 */
+	std::array<std::vector<uint32_t>, Ds4Input::axisCount> axes;
+
+	/**
+	 * \brief Ops depending on any touch region.
+	 */
+	std::vector<uint32_t> touch;
+
+	/**
+	 * \brief Ops which must be evaluated every tick, such as rapid fire or analog outputs.
+	 */
+	std::vector<uint32_t> always;
+
+	void clear();
+
+	/**
+	 * \brief Adds an op to the index of each input source in \p source.
+	 * \param op The index of the op in its plan array.
+	 * \param source The input sources \p op depends on.
+	 */
+	void add(uint32_t op, const BindingPlanSource& source);
+
+	/**
+	 * \brief Adds the ops affected by the given changes to \p out.
+	 * \param changedButtons Buttons pressed or released since the last tick.
+	 * \param changedAxes Axes changed since the last tick.
+	 * \param touchChanged \c true if any touch region may have changed state since the last tick.
+	 * \param out The ops to evaluate. Any ops already present are kept.
+	 */
+	void collect(Ds4Buttons_t changedButtons, Ds4Axes_t changedAxes, bool touchChanged, BindingPlanOpSet& out) const;
+};
+
+/**
+ * \brief Inputs claimed by active modifier bindings. Any other map bound to a claimed input
+ * is overridden by the modifier binding which claims it.
+ */
+struct BindingPlanSuppression
+{
+	/**
+	 * \brief Inputs claimed by at least one active modifier binding.
+	 * Touch regions are a bitset indexed by \c BindingPlanSource::touchRegionId.
+	 */
+	Ds4Buttons_t buttons = 0;
+	Ds4Axes_t axes = 0;
+	std::vector<uint64_t> touchRegions;
+
+	/**
+	 * \brief Inputs claimed by at least two active modifier bindings.
+	 * This allows a modifier binding to exclude its own claim.
+	 */
+	Ds4Buttons_t sharedButtons = 0;
+	Ds4Axes_t sharedAxes = 0;
+	std::vector<uint64_t> sharedTouchRegions;
+
+	/**
+	 * \brief Releases all claims.
+	 * \param touchRegionCount The number of touch regions in the plan.
+	 */
+	void reset(size_t touchRegionCount);
+
+	/**
+	 * \brief Claims the inputs of an active modifier binding.
+	 */
+	void add(const BindingPlanSource& source);
+
+	/**
+	 * \brief Determines if any input of \p source has been claimed.
+	 * \param source The input sources to check.
+	 * \param claimsItself \c true if \p source belongs to an active modifier binding, whose own claim is ignored.
+	 */
+	[[nodiscard]] bool suppresses(const BindingPlanSource& source, bool claimsItself) const;
+};
+
+/**
+ * \brief A \c DeviceProfile lowered into flat, contiguous arrays which can be evaluated linearly each tick.
+ * Input sources, axis options and touch regions are resolved once at compile time rather than looked up per tick.
+ * The compiled plan refers to the profile's bindings, modifiers and touch regions, so it must be recompiled
+ * whenever they are modified.
+ */
+class BindingPlan
+{
+public:
+	/**
+	 * \brief Modifier sets with at least one valid input source, ordered by input source. \sa compile
+	 */
+	std::vector<ModifierPlanOp> modifiers;
+
+	/**
+	 * \brief Top-level bindings with at least one valid input source, ordered by input source. \sa compile
+	 */
+	std::vector<BindingPlanOp> bindings;
+
+	/**
+	 * \brief The bindings of every modifier set in \c modifiers, in profile order.
+	 */
+	std::vector<BindingPlanOp> modifierBindings;
+
+	/**
+	 * \brief Resolved axis options referred to by \c BindingPlanSource::firstAxis.
+	 */
+	std::vector<BindingPlanAxis> axes;
+
+	/**
+	 * \brief Index of \c modifiers by input source. A modifier depends on its own input sources and those of its bindings.
+	 */
+	BindingPlanIndex modifierIndex;
+
+	/**
+	 * \brief Index of \c bindings by input source.
+	 */
+	BindingPlanIndex bindingIndex;
+
+	/**
+	 * \brief The number of touch regions in the compiled profile. \sa BindingPlanSource::touchRegionId
+	 */
+	size_t touchRegionCount = 0;
+
+	/**
+	 * \brief The triggers of every binding and modifier with \c InputType::trigger. \sa BindingPlanSource::triggerId
+	 */
+	InputTriggerEngine triggers;
+
+	/**
+	 * \brief Compiles a profile into this plan, replacing its previous contents.
+	 * Modifiers and bindings are ordered first by their first held button, then by their first axis,
+	 * then by touch region name, which is the order in which they were previously visited per tick.
+	 * Bindings sharing an input source keep their profile order.
+	 * \param profile The profile to compile.
+	 * \param touchRegions The touch regions of \p profile by name.
+	 */
+	void compile(DeviceProfile& profile, const Ds4TouchRegionCache& touchRegions);
+
+	/**
+	 * \brief Clears the plan.
+	 */
+	void clear();
+
+	/**
+	 * \brief Gets the bindings of a modifier set in the plan.
+	 */
+	[[nodiscard]] std::span<const BindingPlanOp> getBindings(const ModifierPlanOp& modifier) const;
+
+	/**
+	 * \brief Gets the resolved axes of an input source in the plan.
+	 */
+	[[nodiscard]] std::span<const BindingPlanAxis> getAxes(const BindingPlanSource& source) const;
+
+private:
+	/**
+	 * \brief Resolves the input sources of a binding or modifier.
+	 * \return \c true if \p map has at least one valid input source.
+	 */
+	bool resolveSource(const InputMapBase& map, const Ds4TouchRegionCache& touchRegions, BindingPlanSource& source);
+
+	/**
+	 * \brief Determines if a binding must be evaluated every tick regardless of input changes,
+	 * i.e. if it has rapid fire, an analog output, a touch region with continuous output, or a timed trigger.
+	 */
+	[[nodiscard]] bool isContinuous(const BindingPlanOp& op) const;
+
+	void buildIndices();
+};
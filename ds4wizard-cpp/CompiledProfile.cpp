@@ -0,0 +1,27 @@
+#include "pch.h"
+
+#include "CompiledProfile.h"
+#include "InputSimulator.h"
+#include "ISimulator.h"
+
+CompiledProfile::CompiledProfile(DeviceProfile profile, InputSimulator* simulator)
+	: profile(std::move(profile))
+{
+	touchRegionsById.reserve(this->profile.touchRegions.size());
+
+	for (auto& pair : this->profile.touchRegions)
+	{
+		touchRegions[pair.first] = &pair.second;
+		touchRegionsById.emplace_back(&pair.second);
+		pair.second.setTouchHistory(&simulator->touchHistory());
+		pair.second.setTouchGestures(&simulator->touchGestures());
+
+		if (ISimulator* regionSimulator = pair.second.getSimulator(simulator))
+		{
+			regionSimulators.push_back(regionSimulator);
+		}
+	}
+
+	touchRegionGrid.build(touchRegionsById);
+	plan.compile(this->profile, touchRegions);
+}
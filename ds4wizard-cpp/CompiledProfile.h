@@ -0,0 +1,59 @@
+#pragma once
+
+#include <vector>
+
+#include "BindingPlan.h"
+#include "DeviceProfile.h"
+#include "Ds4TouchRegion.h"
+#include "Ds4TouchRegionGrid.h"
+
+class InputSimulator;
+class ISimulator;
+
+/**
+ * \brief A profile together with everything \c InputSimulator derives from it: touch region lookups,
+ * touch region simulators and the compiled \c BindingPlan.
+ * It is built away from the device thread, then handed to the simulator whole, after which only
+ * the device thread uses it. Its plan and caches point into \c profile, so it is never copied or moved.
+ * \sa InputSimulator::publishProfile
+ */
+class CompiledProfile
+{
+public:
+	DeviceProfile profile;
+
+	/**
+	 * \brief The touch regions of \c profile by name.
+	 */
+	Ds4TouchRegionCache touchRegions;
+
+	/**
+	 * \brief The touch regions of \c profile, ordered by name. The position of each region is its ID,
+	 * matching \c BindingPlanSource::touchRegionId.
+	 */
+	std::vector<Ds4TouchRegion*> touchRegionsById;
+
+	/**
+	 * \brief The touch regions of \c touchRegionsById by their position on the touchpad.
+	 */
+	Ds4TouchRegionGrid touchRegionGrid;
+
+	/**
+	 * \brief Simulators driven by the touch regions of \c profile, such as trackballs.
+	 */
+	std::vector<ISimulator*> regionSimulators;
+
+	BindingPlan plan;
+
+	/**
+	 * \brief Compiles a profile.
+	 * \param profile The profile to compile. The compiled profile keeps its own copy.
+	 * \param simulator The simulator the profile will be applied to, which owns its touch region simulators.
+	 */
+	CompiledProfile(DeviceProfile profile, InputSimulator* simulator);
+
+	CompiledProfile(const CompiledProfile&) = delete;
+	CompiledProfile(CompiledProfile&&) = delete;
+	CompiledProfile& operator=(const CompiledProfile&) = delete;
+	CompiledProfile& operator=(CompiledProfile&&) = delete;
+};
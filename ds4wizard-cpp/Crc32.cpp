@@ -0,0 +1,103 @@
+#include "pch.h"
+
+#include <array>
+#include <cstring>
+
+#if defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#define CRC32_ARM
+#elif defined(_M_ARM64)
+#include <intrin.h>
+#define CRC32_ARM
+#endif
+
+#include "Crc32.h"
+
+namespace
+{
+#ifndef CRC32_ARM
+	constexpr uint32_t polynomial = 0xEDB88320;
+
+	/**
+	 * \brief Lookup tables for slicing-by-8. \c tables[0] is the classic
+	 * byte-wise table; \c tables[n] advances a byte through \c n additional zero bytes.
+	 */
+	constexpr auto tables = []
+	{
+		std::array<std::array<uint32_t, 256>, 8> result {};
+
+		for (uint32_t i = 0; i < 256; ++i)
+		{
+			uint32_t crc = i;
+
+			for (int bit = 0; bit < 8; ++bit)
+			{
+				crc = (crc >> 1) ^ (polynomial & (0u - (crc & 1)));
+			}
+
+			result[0][i] = crc;
+		}
+
+		for (uint32_t i = 0; i < 256; ++i)
+		{
+			for (size_t n = 1; n < result.size(); ++n)
+			{
+				const uint32_t previous = result[n - 1][i];
+				result[n][i] = (previous >> 8) ^ result[0][previous & 0xFF];
+			}
+		}
+
+		return result;
+	}();
+#endif
+}
+
+uint32_t Crc32::compute(std::span<const uint8_t> data, uint32_t crc)
+{
+	crc = ~crc;
+
+	const uint8_t* p = data.data();
+	size_t size = data.size();
+
+#ifdef CRC32_ARM
+	for (; size >= sizeof(uint64_t); size -= sizeof(uint64_t), p += sizeof(uint64_t))
+	{
+		uint64_t word;
+		std::memcpy(&word, p, sizeof(word));
+		crc = __crc32d(crc, word);
+	}
+
+	for (; size > 0; --size, ++p)
+	{
+		crc = __crc32b(crc, *p);
+	}
+#else
+	// Assumes a little-endian host, which is true of every platform this runs on.
+	for (; size >= sizeof(uint64_t); size -= sizeof(uint64_t), p += sizeof(uint64_t))
+	{
+		uint32_t lo;
+		uint32_t hi;
+
+		std::memcpy(&lo, p, sizeof(lo));
+		std::memcpy(&hi, p + sizeof(lo), sizeof(hi));
+
+		lo ^= crc;
+
+		crc = tables[7][lo & 0xFF] ^
+		      tables[6][(lo >> 8) & 0xFF] ^
+		      tables[5][(lo >> 16) & 0xFF] ^
+		      tables[4][lo >> 24] ^
+		      tables[3][hi & 0xFF] ^
+		      tables[2][(hi >> 8) & 0xFF] ^
+		      tables[1][(hi >> 16) & 0xFF] ^
+		      tables[0][hi >> 24];
+	}
+
+	for (; size > 0; --size, ++p)
+	{
+		crc = (crc >> 8) ^ tables[0][(crc ^ *p) & 0xFF];
+	}
+#endif
+
+	return ~crc;
+}
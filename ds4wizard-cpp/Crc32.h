@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+
+/**
+ * \brief Computes the standard (IEEE 802.3, reflected 0x04C11DB7) CRC-32,
+ * as used by Bluetooth DualShock 4 reports.
+ */
+class Crc32
+{
+public:
+	/**
+	 * \brief Computes the CRC of \p data, continuing from a previous result.
+	 * \param data The data to compute the CRC of.
+	 * \param crc The result of a previous call to continue from, or \c 0 to start a new CRC.
+	 * \return The CRC of all data passed so far.
+	 */
+	static uint32_t compute(std::span<const uint8_t> data, uint32_t crc = 0);
+};
@@ -51,6 +51,7 @@ DevicePropertiesDialog::DevicePropertiesDialog(QWidget* parent, std::shared_ptr<
 		qRegisterMetaType<Ds4Buttons_t>("Ds4Buttons_t");
 		connect(this, &DevicePropertiesDialog::readoutChanged, this, &DevicePropertiesDialog::updateReadout);
 		connect(ui.buttonResetPeak, &QToolButton::clicked, this, &DevicePropertiesDialog::resetPeakLatency);
+		connect(ui.buttonCapture, &QPushButton::toggled, this, &DevicePropertiesDialog::captureToggled);
 	}
 	else
 	{
@@ -84,6 +85,11 @@ void DevicePropertiesDialog::populateForm()
 
 	ui.lineEdit_DeviceName->setText(QString::fromStdString(oldSettings.name));
 
+	{
+		const QSignalBlocker blocker(ui.buttonCapture);
+		ui.buttonCapture->setChecked(device->capturing());
+	}
+
 	ui.checkBox_UseProfileLight->setChecked(oldSettings.useProfileLight);
 	ui.checkBox_AutoLightColor->setChecked(oldSettings.light.automaticColor);
 
@@ -261,6 +267,36 @@ void DevicePropertiesDialog::resetPeakLatency() const
 	device->resetReadLatencyPeak();
 }
 
+void DevicePropertiesDialog::captureToggled(bool checked)
+{
+	if (!checked)
+	{
+		device->stopCapture();
+		return;
+	}
+
+	const QString path = QFileDialog::getSaveFileName(this, tr("Record Input"), QString(),
+	                                                  tr("Input captures (*.ds4c);;All files (*)"));
+
+	const QSignalBlocker blocker(ui.buttonCapture);
+
+	if (path.isEmpty())
+	{
+		ui.buttonCapture->setChecked(false);
+		return;
+	}
+
+	try
+	{
+		device->startCapture(path.toStdWString());
+	}
+	catch (const std::exception& ex)
+	{
+		ui.buttonCapture->setChecked(false);
+		QMessageBox::warning(this, tr("Warning"), tr("Unable to record input: %1").arg(QString::fromStdString(ex.what())));
+	}
+}
+
 void DevicePropertiesDialog::profileEditClicked(bool /*checked*/)
 {
 	// TODO: implement actual functionality
@@ -45,6 +45,7 @@ private slots:
 	void tabChanged(int index);
 	void updateReadout(Ds4Buttons_t heldButtons, Ds4InputData data) const;
 	void resetPeakLatency() const;
+	void captureToggled(bool checked);
 	void profileEditClicked(bool checked);
 	void colorEditClicked(bool checked);
 	void buttonBoxAccepted();
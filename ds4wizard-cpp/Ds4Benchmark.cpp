@@ -0,0 +1,592 @@
+#include "pch.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <iomanip>
+#include <numbers>
+
+#include "Ds4Benchmark.h"
+#include "Ds4Input.h"
+#include "Ds4Output.h"
+#include "CompiledProfile.h"
+#include "InputSimulator.h"
+#include "TickClock.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#ifdef DS4W_COUNT_ALLOCATIONS
+
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+	std::atomic<uint64_t> allocations { 0 };
+}
+
+void* operator new(size_t size)
+{
+	allocations.fetch_add(1, std::memory_order_relaxed);
+
+	if (void* p = std::malloc(size == 0 ? 1 : size))
+	{
+		return p;
+	}
+
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+	std::free(p);
+}
+
+#endif
+
+using namespace std::chrono;
+
+namespace
+{
+	constexpr short touchpadWidth  = 1920;
+	constexpr short touchpadHeight = 943;
+
+	/**
+	 * \brief The size of a USB input report, including the report ID.
+	 */
+	constexpr size_t usbReportSize = 64;
+
+	/**
+	 * \brief A hardware performance counter for the calling thread, where the platform provides one.
+	 */
+	class PerfCounter
+	{
+	public:
+		enum class Type
+		{
+			cacheMisses,
+			instructions
+		};
+
+	private:
+		int fd = -1;
+
+	public:
+		explicit PerfCounter(Type type)
+		{
+		#ifdef __linux__
+			perf_event_attr attr {};
+
+			attr.type           = PERF_TYPE_HARDWARE;
+			attr.size           = sizeof(attr);
+			attr.config         = type == Type::cacheMisses ? PERF_COUNT_HW_CACHE_MISSES : PERF_COUNT_HW_INSTRUCTIONS;
+			attr.disabled       = 1;
+			attr.exclude_kernel = 1;
+			attr.exclude_hv     = 1;
+
+			fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+		#endif
+		}
+
+		~PerfCounter()
+		{
+		#ifdef __linux__
+			if (fd >= 0)
+			{
+				close(fd);
+			}
+		#endif
+		}
+
+		PerfCounter(const PerfCounter&) = delete;
+		PerfCounter& operator=(const PerfCounter&) = delete;
+
+		void start() const
+		{
+		#ifdef __linux__
+			if (fd >= 0)
+			{
+				ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+				ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+			}
+		#endif
+		}
+
+		/**
+		 * \brief Stops counting and gets the count since \c start, or \c std::nullopt if the counter is unavailable.
+		 */
+		std::optional<uint64_t> stop() const
+		{
+		#ifdef __linux__
+			uint64_t count = 0;
+
+			if (fd >= 0 && ioctl(fd, PERF_EVENT_IOC_DISABLE, 0) == 0 &&
+			    read(fd, &count, sizeof(count)) == static_cast<ssize_t>(sizeof(count)))
+			{
+				return count;
+			}
+		#endif
+
+			return std::nullopt;
+		}
+	};
+
+	std::optional<double> perTick(std::optional<uint64_t> count, size_t ticks)
+	{
+		if (!count.has_value() || ticks == 0)
+		{
+			return std::nullopt;
+		}
+
+		return static_cast<double>(*count) / static_cast<double>(ticks);
+	}
+
+	/**
+	 * \brief The input data of a captured report without its report ID or Bluetooth header,
+	 * or an empty span if it is too short to decode.
+	 */
+	std::span<const uint8_t> inputData(const Ds4CaptureRecord& record)
+	{
+		const std::span<const uint8_t> report = record.data();
+		const size_t offset = record.connectionType == (+ConnectionType::usb)._to_integral() ? 1 : 3;
+
+		if (report.size() < offset + Ds4Input::minimumReportSize)
+		{
+			return {};
+		}
+
+		return report.subspan(offset);
+	}
+
+	/**
+	 * \brief The raw buttons cycled through by generated reports. The d-pad is left centered.
+	 */
+	constexpr std::array<Ds4ButtonsRaw_t, 14> reportButtons {
+		Ds4ButtonsRaw::square, Ds4ButtonsRaw::cross, Ds4ButtonsRaw::circle, Ds4ButtonsRaw::triangle,
+		Ds4ButtonsRaw::l1, Ds4ButtonsRaw::r1, Ds4ButtonsRaw::l2, Ds4ButtonsRaw::r2,
+		Ds4ButtonsRaw::share, Ds4ButtonsRaw::options, Ds4ButtonsRaw::l3, Ds4ButtonsRaw::r3,
+		Ds4ButtonsRaw::ps, Ds4ButtonsRaw::touchButton
+	};
+
+	constexpr Ds4ButtonsRaw_t hatCentered = 8;
+
+	/**
+	 * \brief Input offsets within a USB report, which are those of \c Ds4Input::decode offset by the report ID.
+	 */
+	namespace UsbReportLayout
+	{
+		constexpr size_t leftStick    = 1;
+		constexpr size_t rightStick   = 3;
+		constexpr size_t buttons      = 5;
+		constexpr size_t frameCount   = 7;
+		constexpr size_t leftTrigger  = 8;
+		constexpr size_t rightTrigger = 9;
+		constexpr size_t timestamp    = 10;
+		constexpr size_t status       = 30;
+		constexpr size_t touchFrame   = 34;
+		constexpr size_t touch1       = 35;
+		constexpr size_t touch2       = 39;
+	}
+
+	/**
+	 * \brief The button bound by the \p i th generated binding or modifier, skipping the d-pad.
+	 */
+	Ds4Buttons_t bindingButton(size_t i)
+	{
+		return Ds4Buttons::fromRaw(reportButtons[i % reportButtons.size()]);
+	}
+
+	std::string regionName(size_t i)
+	{
+		return "region " + std::to_string(i);
+	}
+
+	InputMap makeBinding(size_t i, size_t touchRegionCount)
+	{
+		const size_t kind = i % 4;
+
+		if (kind == 3 && touchRegionCount > 0)
+		{
+			InputMap map(SimulatorType::input, InputType::touchRegion, OutputType::xinput);
+			map.inputTouchRegion = regionName(i % touchRegionCount);
+			map.xinputButtons    = XInputButtons_values[i % XInputButtons_values.size()];
+			return map;
+		}
+
+		if (kind == 2)
+		{
+			// sticks and triggers only; motion axes are noisy and would dominate every tick
+			InputMap map(SimulatorType::input, InputType::axis, OutputType::xinput);
+			map.inputAxes = Ds4Axes_values[i % 6];
+
+			XInputAxes axes;
+			axes.axes = XInputAxis_values[i % XInputAxis_values.size()];
+			map.xinputAxes = axes;
+
+			return map;
+		}
+
+		InputMap map(SimulatorType::input, InputType::button, OutputType::xinput);
+		map.inputButtons  = bindingButton(i);
+		map.xinputButtons = XInputButtons_values[i % XInputButtons_values.size()];
+		return map;
+	}
+
+	void writeTouch(std::span<uint8_t> p, bool active, uint8_t id, short x, short y)
+	{
+		p[0] = static_cast<uint8_t>((active ? 0 : 0x80) | (id & 0x7F));
+		p[1] = static_cast<uint8_t>(x & 0xFF);
+		p[2] = static_cast<uint8_t>(((x >> 8) & 0x0F) | ((y & 0x0F) << 4));
+		p[3] = static_cast<uint8_t>(y >> 4);
+	}
+}
+
+std::vector<Ds4BenchmarkScenario> Ds4Benchmark::defaultScenarios()
+{
+	return {
+		{ "1 binding",                  1,      0,   0,  0 },
+		{ "1 binding, 1 modifier",      1,      1,   1,   0 },
+		{ "10 bindings",                10,     0,   0,  0 },
+		{ "100 bindings",               100,    0,   0,  4 },
+		{ "100 bindings, 4 modifiers",  100,    4,   25, 4 },
+		{ "1k bindings, 8 modifiers",   1'000,  8,   50, 16 },
+		{ "10k bindings",               10'000, 0,   0,  64 },
+		{ "10k bindings, 14 modifiers", 10'000, 14,  100, 64 }
+	};
+}
+
+DeviceProfile Ds4Benchmark::makeProfile(const Ds4BenchmarkScenario& scenario)
+{
+	DeviceProfile profile;
+	profile.name = scenario.name;
+
+	if (scenario.touchRegionCount > 0)
+	{
+		const auto columns = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(scenario.touchRegionCount))));
+		const size_t rows  = (scenario.touchRegionCount + columns - 1) / columns;
+
+		const auto width  = static_cast<short>(touchpadWidth / columns);
+		const auto height = static_cast<short>(touchpadHeight / rows);
+
+		for (size_t i = 0; i < scenario.touchRegionCount; ++i)
+		{
+			const auto left = static_cast<short>((i % columns) * width);
+			const auto top  = static_cast<short>((i / columns) * height);
+
+			profile.touchRegions.emplace(regionName(i),
+			                             Ds4TouchRegion(Ds4TouchRegionType::button, left, top,
+			                                            static_cast<short>(left + width - 1), static_cast<short>(top + height - 1)));
+		}
+	}
+
+	for (size_t i = 0; i < scenario.bindingCount; ++i)
+	{
+		profile.bindings.emplace_back(makeBinding(i, scenario.touchRegionCount));
+	}
+
+	for (size_t i = 0; i < scenario.modifierCount; ++i)
+	{
+		InputModifier modifier(InputType::button, static_cast<Ds4Buttons::T>(bindingButton(i)));
+
+		for (size_t j = 0; j < scenario.bindingsPerModifier; ++j)
+		{
+			// offset so a modifier's bindings are not all bound to the modifier's own button
+			modifier.bindings.emplace_back(makeBinding(i + j + 1, scenario.touchRegionCount));
+		}
+
+		profile.modifiers.emplace_back(std::move(modifier));
+	}
+
+	return profile;
+}
+
+std::vector<Ds4CaptureRecord> Ds4Benchmark::makeReports(size_t count)
+{
+	std::vector<Ds4CaptureRecord> records(count);
+
+	// a report every millisecond in units of Ds4Input::DeviceDuration
+	const auto deviceInterval = static_cast<uint16_t>(duration_cast<Ds4Input::DeviceDuration>(milliseconds(1)).count());
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		Ds4CaptureRecord& record = records[i];
+
+		record.timestamp      = static_cast<uint64_t>(duration_cast<nanoseconds>(milliseconds(i)).count());
+		record.connectionType = static_cast<uint8_t>((+ConnectionType::usb)._to_integral());
+		record.size           = static_cast<uint16_t>(usbReportSize);
+
+		std::span<uint8_t> report(record.report.data(), record.size);
+		namespace layout = UsbReportLayout;
+
+		report[0] = 0x01;
+
+		// sweep the sticks and triggers over a one second period
+		const double phase = 2.0 * std::numbers::pi * static_cast<double>(i % 1000) / 1000.0;
+		const auto sweep   = [](double value) { return static_cast<uint8_t>(127.5 + 127.5 * value); };
+
+		report[layout::leftStick]      = sweep(std::cos(phase));
+		report[layout::leftStick + 1]  = sweep(std::sin(phase));
+		report[layout::rightStick]     = sweep(std::sin(phase));
+		report[layout::rightStick + 1] = sweep(std::cos(phase));
+		report[layout::leftTrigger]    = sweep(std::sin(phase));
+		report[layout::rightTrigger]   = sweep(-std::sin(phase));
+
+		// hold each button for 8 reports, overlapping with the next so chords occur
+		const size_t step = i / 8;
+		Ds4ButtonsRaw_t buttons = hatCentered | reportButtons[step % reportButtons.size()];
+
+		if (i % 8 >= 4)
+		{
+			buttons |= reportButtons[(step + 1) % reportButtons.size()];
+		}
+
+		report[layout::buttons]     = static_cast<uint8_t>(buttons);
+		report[layout::buttons + 1] = static_cast<uint8_t>(buttons >> 8);
+		report[layout::frameCount]  = static_cast<uint8_t>(((buttons >> 16) & 0x03) | ((i & 0x3F) << 2));
+
+		const auto timestamp = static_cast<uint16_t>(i * deviceInterval);
+		report[layout::timestamp]     = static_cast<uint8_t>(timestamp);
+		report[layout::timestamp + 1] = static_cast<uint8_t>(timestamp >> 8);
+
+		// wired, fully charged
+		report[layout::status] = 0x1B;
+
+		// drag a touch across the touchpad for 200 reports, then lift for 50
+		const size_t touchStep = i % 250;
+		const bool touching    = touchStep < 200;
+		const auto touchId     = static_cast<uint8_t>(i / 250);
+
+		const auto x = static_cast<short>(touchStep * touchpadWidth / 200);
+		const auto y = static_cast<short>((i / 250) * 97 % touchpadHeight);
+
+		report[layout::touchFrame] = static_cast<uint8_t>(i);
+		writeTouch(report.subspan(layout::touch1, 4), touching, touchId, std::min<short>(x, touchpadWidth - 1), y);
+		writeTouch(report.subspan(layout::touch2, 4), false, 0, 0, 0);
+	}
+
+	return records;
+}
+
+Ds4BenchmarkResult Ds4Benchmark::run(const Ds4BenchmarkScenario& scenario)
+{
+	const std::vector<Ds4CaptureRecord> records = makeReports(scenario.reportCount);
+	return run(scenario, records);
+}
+
+Ds4BenchmarkResult Ds4Benchmark::run(const Ds4BenchmarkScenario& scenario, std::span<const Ds4CaptureRecord> records)
+{
+	Ds4BenchmarkResult result;
+	result.scenario = scenario;
+
+	if (records.empty())
+	{
+		return result;
+	}
+
+	// every timer reads the time each report was captured rather than the time it is processed
+	auto captureTime = [](const Ds4CaptureRecord& record)
+	{
+		return Stopwatch::TimePoint(duration_cast<Stopwatch::Duration>(nanoseconds(record.timestamp)));
+	};
+
+	VirtualClock clock(captureTime(records.front()));
+	const TickClock::ScopedSource source(clock);
+
+	Ds4Input input {};
+	Ds4Output output {};
+	Ds4BenchmarkSinks sinks;
+
+	InputSimulator simulator(input, output, sinks.sinks());
+	simulator.applyProfile(std::make_unique<CompiledProfile>(makeProfile(scenario), &simulator));
+	simulator.start();
+
+	const PerfCounter cacheMisses(PerfCounter::Type::cacheMisses);
+	const PerfCounter instructions(PerfCounter::Type::instructions);
+
+	Stopwatch::Duration total {};
+	uint64_t firstAllocation = 0;
+
+	const size_t warmupCount = std::min(scenario.warmupCount, records.size() - 1);
+
+	for (size_t i = 0; i < records.size(); ++i)
+	{
+		const std::span<const uint8_t> data = inputData(records[i]);
+
+		if (i == warmupCount)
+		{
+			firstAllocation = allocationCount();
+			cacheMisses.start();
+			instructions.start();
+		}
+
+		if (data.empty())
+		{
+			continue;
+		}
+
+		clock.set(captureTime(records[i]));
+
+		// the virtual clock only affects TickClock, so the cost of a tick is measured by the real one
+		const Stopwatch::TimePoint start = Stopwatch::Clock::now();
+
+		{
+			const TickClock::Tick tick;
+
+			input.update(data);
+			simulator.runMaps();
+		}
+
+		if (i >= warmupCount)
+		{
+			const Stopwatch::Duration elapsed = Stopwatch::Clock::now() - start;
+
+			total += elapsed;
+			result.maxTick = std::max(result.maxTick, duration_cast<nanoseconds>(elapsed));
+			++result.ticks;
+		}
+	}
+
+	const std::optional<uint64_t> cacheMissCount  = cacheMisses.stop();
+	const std::optional<uint64_t> instructionCount = instructions.stop();
+
+	if (result.ticks > 0)
+	{
+		result.meanTick = duration_cast<nanoseconds>(total) / result.ticks;
+
+		if (countsAllocations())
+		{
+			result.allocationsPerTick = static_cast<double>(allocationCount() - firstAllocation) / static_cast<double>(result.ticks);
+		}
+
+		result.cacheMissesPerTick  = perTick(cacheMissCount, result.ticks);
+		result.instructionsPerTick = perTick(instructionCount, result.ticks);
+	}
+
+	return result;
+}
+
+void Ds4Benchmark::print(std::ostream& stream, std::span<const Ds4BenchmarkResult> results)
+{
+	auto optional = [&](const std::optional<double>& value, int width)
+	{
+		if (value.has_value())
+		{
+			stream << std::setw(width) << std::fixed << std::setprecision(2) << *value;
+		}
+		else
+		{
+			stream << std::setw(width) << "n/a";
+		}
+	};
+
+	stream << std::left << std::setw(32) << "scenario" << std::right
+	       << std::setw(9) << "ticks"
+	       << std::setw(13) << "ns/tick"
+	       << std::setw(13) << "max ns"
+	       << std::setw(13) << "allocs/tick"
+	       << std::setw(13) << "misses/tick"
+	       << std::setw(13) << "instr/tick" << '\n';
+
+	for (const Ds4BenchmarkResult& result : results)
+	{
+		stream << std::left << std::setw(32) << result.scenario.name << std::right
+		       << std::setw(9) << result.ticks
+		       << std::setw(13) << result.meanTick.count()
+		       << std::setw(13) << result.maxTick.count();
+
+		optional(result.allocationsPerTick, 13);
+		optional(result.cacheMissesPerTick, 13);
+		optional(result.instructionsPerTick, 13);
+
+		stream << '\n';
+	}
+}
+
+bool Ds4Benchmark::countsAllocations()
+{
+#ifdef DS4W_COUNT_ALLOCATIONS
+	return true;
+#else
+	return false;
+#endif
+}
+
+uint64_t Ds4Benchmark::allocationCount()
+{
+#ifdef DS4W_COUNT_ALLOCATIONS
+	return allocations.load(std::memory_order_relaxed);
+#else
+	return 0;
+#endif
+}
+
+void Ds4BenchmarkSinks::keyDown(int /*keyCode*/)
+{
+	++events;
+}
+
+void Ds4BenchmarkSinks::keyUp(int /*keyCode*/)
+{
+	++events;
+}
+
+void Ds4BenchmarkSinks::buttonDown(MouseButton /*button*/)
+{
+	++events;
+}
+
+void Ds4BenchmarkSinks::buttonUp(MouseButton /*button*/)
+{
+	++events;
+}
+
+void Ds4BenchmarkSinks::moveBy(int /*dx*/, int /*dy*/)
+{
+	++events;
+}
+
+bool Ds4BenchmarkSinks::connect()
+{
+	connected_ = true;
+	return true;
+}
+
+void Ds4BenchmarkSinks::disconnect()
+{
+	connected_ = false;
+}
+
+bool Ds4BenchmarkSinks::connected() const
+{
+	return connected_;
+}
+
+void Ds4BenchmarkSinks::update(const XInputGamepad& /*state*/)
+{
+	++events;
+}
+
+XInputVibration Ds4BenchmarkSinks::vibration() const
+{
+	return {};
+}
+
+void Ds4BenchmarkSinks::runAction(ActionType /*action*/)
+{
+	++events;
+}
+
+InputSimulatorSinks Ds4BenchmarkSinks::sinks()
+{
+	return { this, this, this, this };
+}
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "Ds4Capture.h"
+#include "DeviceProfile.h"
+#include "InputSinks.h"
+
+/**
+ * \brief The shape of a generated profile and input stream to benchmark the mapping engine with.
+ * \sa Ds4Benchmark
+ */
+struct Ds4BenchmarkScenario
+{
+	std::string name;
+
+	/**
+	 * \brief The number of top-level bindings. Bindings are spread across buttons, axes and touch regions.
+	 */
+	size_t bindingCount = 0;
+
+	/**
+	 * \brief The number of modifier sets, each bound to a button.
+	 */
+	size_t modifierCount = 0;
+
+	/**
+	 * \brief The number of bindings in each modifier set.
+	 */
+	size_t bindingsPerModifier = 0;
+
+	/**
+	 * \brief The number of touch regions, laid out as a grid over the touchpad.
+	 */
+	size_t touchRegionCount = 0;
+
+	/**
+	 * \brief The number of input reports to generate.
+	 */
+	size_t reportCount = 10'000;
+
+	/**
+	 * \brief The number of reports processed before measurement begins, so that anything sized
+	 * by the first few reports (e.g. touch history) has settled.
+	 */
+	size_t warmupCount = 1'000;
+};
+
+/**
+ * \brief The result of running a \c Ds4BenchmarkScenario.
+ */
+struct Ds4BenchmarkResult
+{
+	Ds4BenchmarkScenario scenario;
+
+	/**
+	 * \brief The number of reports which were processed and simulated after warm-up.
+	 */
+	size_t ticks = 0;
+
+	/**
+	 * \brief The mean and longest time taken to process and simulate a single report.
+	 */
+	std::chrono::nanoseconds meanTick {};
+	std::chrono::nanoseconds maxTick {};
+
+	/**
+	 * \brief The mean number of heap allocations per tick, or \c std::nullopt
+	 * if allocation counting was not compiled in. \sa Ds4Benchmark::countsAllocations
+	 */
+	std::optional<double> allocationsPerTick;
+
+	/**
+	 * \brief The mean number of cache misses and instructions per tick as counted by the CPU,
+	 * or \c std::nullopt where performance counters are unavailable (e.g. outside Linux, or without permission).
+	 */
+	std::optional<double> cacheMissesPerTick;
+	std::optional<double> instructionsPerTick;
+};
+
+/**
+ * \brief Sinks which discard simulated output, so that the mapping engine can be driven without
+ * a keyboard, mouse or virtual pad. Output is only counted.
+ */
+class Ds4BenchmarkSinks : public IKeyboardSink, public IMouseSink, public IVirtualPadSink, public IDeviceActionSink
+{
+	bool connected_ = false;
+
+public:
+	/**
+	 * \brief The number of outputs received by any sink.
+	 */
+	uint64_t events = 0;
+
+	void keyDown(int keyCode) override;
+	void keyUp(int keyCode) override;
+
+	void buttonDown(MouseButton button) override;
+	void buttonUp(MouseButton button) override;
+	void moveBy(int dx, int dy) override;
+
+	bool connect() override;
+	void disconnect() override;
+	[[nodiscard]] bool connected() const override;
+	void update(const XInputGamepad& state) override;
+	[[nodiscard]] XInputVibration vibration() const override;
+
+	void runAction(ActionType action) override;
+
+	/**
+	 * \brief This object as every sink of an \c InputSimulator.
+	 */
+	[[nodiscard]] InputSimulatorSinks sinks();
+};
+
+/**
+ * \brief Measures the cost of the mapping engine per input report, independent of any physical device.
+ * Profiles are generated programmatically, and each report is decoded by \c Ds4Input and simulated by
+ * an \c InputSimulator whose output goes to \c Ds4BenchmarkSinks. Timers run on the reports' own timestamps.
+ */
+class Ds4Benchmark
+{
+public:
+	/**
+	 * \brief Scenarios ranging from a single binding to 10,000 bindings.
+	 */
+	static std::vector<Ds4BenchmarkScenario> defaultScenarios();
+
+	/**
+	 * \brief Generates a profile with the shape described by \p scenario.
+	 */
+	static DeviceProfile makeProfile(const Ds4BenchmarkScenario& scenario);
+
+	/**
+	 * \brief Generates a stream of USB input reports one millisecond apart which
+	 * cycle through buttons, sweep the sticks and triggers, and drag a touch across the touchpad.
+	 * \param count The number of reports to generate.
+	 */
+	static std::vector<Ds4CaptureRecord> makeReports(size_t count);
+
+	/**
+	 * \brief Runs a scenario against generated input reports.
+	 */
+	static Ds4BenchmarkResult run(const Ds4BenchmarkScenario& scenario);
+
+	/**
+	 * \brief Runs a scenario against previously captured input reports
+	 * in place of generated ones. \c Ds4BenchmarkScenario::reportCount is ignored.
+	 * Reports which are too short to decode are skipped.
+	 */
+	static Ds4BenchmarkResult run(const Ds4BenchmarkScenario& scenario, std::span<const Ds4CaptureRecord> records);
+
+	/**
+	 * \brief Writes results as a table, one scenario per line.
+	 */
+	static void print(std::ostream& stream, std::span<const Ds4BenchmarkResult> results);
+
+	/**
+	 * \brief Indicates if heap allocations are counted, which requires building with \c DS4W_COUNT_ALLOCATIONS.
+	 * Doing so replaces the global \c operator new of the whole program.
+	 */
+	static bool countsAllocations();
+
+	/**
+	 * \brief Gets the number of heap allocations made by the process so far,
+	 * or \c 0 if \c countsAllocations is \c false.
+	 */
+	static uint64_t allocationCount();
+};
@@ -0,0 +1,95 @@
+#include "pch.h"
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+#include "Ds4Capture.h"
+#include "TickClock.h"
+
+using namespace std::chrono;
+
+std::span<const uint8_t> Ds4CaptureRecord::data() const
+{
+	return std::span(report.data(), std::min<size_t>(size, report.size()));
+}
+
+Ds4CaptureWriter::Ds4CaptureWriter(const std::filesystem::path& path)
+	: file(path, std::ios::binary | std::ios::app)
+{
+	if (!file.is_open())
+	{
+		throw std::runtime_error(std::string("failed to open \"")
+		                         + path.string()
+		                         + "\" for writing");
+	}
+
+	if (std::filesystem::file_size(path) > 0)
+	{
+		return;
+	}
+
+	Ds4CaptureHeader header {};
+	header.recordSize  = static_cast<uint16_t>(sizeof(Ds4CaptureRecord));
+	header.createdTime = static_cast<uint64_t>(duration_cast<nanoseconds>(system_clock::now().time_since_epoch()).count());
+
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+}
+
+void Ds4CaptureWriter::write(ConnectionType connectionType, std::span<const uint8_t> report)
+{
+	Ds4CaptureRecord record {};
+
+	record.timestamp      = static_cast<uint64_t>(duration_cast<nanoseconds>(TickClock::now().time_since_epoch()).count());
+	record.connectionType = static_cast<uint8_t>(connectionType._to_integral());
+	record.size           = static_cast<uint16_t>(std::min(report.size(), record.report.size()));
+
+	std::copy_n(report.begin(), record.size, record.report.begin());
+
+	file.write(reinterpret_cast<const char*>(&record), sizeof(record));
+}
+
+Ds4CaptureReader::Ds4CaptureReader(const std::filesystem::path& path)
+{
+	std::ifstream file(path, std::ios::binary);
+
+	if (!file.is_open())
+	{
+		throw std::runtime_error(std::string("failed to open \"")
+		                         + path.string()
+		                         + "\" for reading");
+	}
+
+	Ds4CaptureHeader header {};
+
+	if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)))
+	{
+		throw std::runtime_error("capture file is too small to contain a header");
+	}
+
+	if (header.magic != Ds4CaptureHeader::expectedMagic)
+	{
+		throw std::runtime_error("not a capture file");
+	}
+
+	if (header.version != Ds4CaptureHeader::currentVersion ||
+	    header.recordSize != sizeof(Ds4CaptureRecord))
+	{
+		throw std::runtime_error("unsupported capture file version");
+	}
+
+	const uintmax_t size = std::filesystem::file_size(path);
+
+	// A partially written trailing record (e.g. from a crash) is ignored.
+	records_.resize(static_cast<size_t>((size - sizeof(Ds4CaptureHeader)) / sizeof(Ds4CaptureRecord)));
+
+	if (!file.read(reinterpret_cast<char*>(records_.data()), static_cast<std::streamsize>(records_.size() * sizeof(Ds4CaptureRecord))))
+	{
+		throw std::runtime_error("failed to read capture file");
+	}
+}
+
+std::span<const Ds4CaptureRecord> Ds4CaptureReader::records() const
+{
+	return records_;
+}
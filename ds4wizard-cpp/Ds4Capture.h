@@ -0,0 +1,139 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <vector>
+
+#include "ConnectionType.h"
+#include "Stopwatch.h"
+
+/**
+ * \brief Header at the start of every capture file.
+ * Capture files are little-endian and consist of this header
+ * followed by any number of fixed-size \c Ds4CaptureRecord entries.
+ */
+struct Ds4CaptureHeader
+{
+	static constexpr std::array<char, 4> expectedMagic { 'D', 'S', '4', 'C' };
+	static constexpr uint16_t currentVersion = 1;
+
+	std::array<char, 4> magic = expectedMagic;
+	uint16_t version = currentVersion;
+
+	/**
+	 * \brief Size of each record in bytes; always \c sizeof(Ds4CaptureRecord) for \c currentVersion.
+	 */
+	uint16_t recordSize = 0;
+
+	/**
+	 * \brief System time at which the file was created, in nanoseconds since the Unix epoch.
+	 */
+	uint64_t createdTime = 0;
+
+	std::array<uint8_t, 16> reserved {};
+};
+
+static_assert(sizeof(Ds4CaptureHeader) == 32);
+
+/**
+ * \brief A single raw input report as it was received from the device.
+ */
+struct Ds4CaptureRecord
+{
+	/**
+	 * \brief Large enough for a USB report (64 bytes) or a Bluetooth 0x11 report (78 bytes).
+	 */
+	static constexpr size_t maxReportSize = 84;
+
+	/**
+	 * \brief Monotonic time at which the report was received, in nanoseconds.
+	 * Only the difference between records is meaningful.
+	 */
+	uint64_t timestamp = 0;
+
+	/**
+	 * \brief The \c ConnectionType the report was received on.
+	 */
+	uint8_t connectionType = 0;
+	uint8_t reserved = 0;
+
+	/**
+	 * \brief Number of valid bytes in \c report.
+	 */
+	uint16_t size = 0;
+
+	/**
+	 * \brief The report exactly as read from the device, including the report ID.
+	 */
+	std::array<uint8_t, maxReportSize> report {};
+
+	[[nodiscard]] std::span<const uint8_t> data() const;
+};
+
+static_assert(sizeof(Ds4CaptureRecord) == 96);
+
+/**
+ * \brief Appends raw input reports to a capture file.
+ */
+class Ds4CaptureWriter
+{
+	std::ofstream file;
+
+public:
+	/**
+	 * \brief Opens \p path for appending, writing a header first if the file is empty.
+	 * \param path The path of the capture file.
+	 * \throws std::runtime_error if the file cannot be opened.
+	 */
+	explicit Ds4CaptureWriter(const std::filesystem::path& path);
+
+	Ds4CaptureWriter(const Ds4CaptureWriter&) = delete;
+	Ds4CaptureWriter& operator=(const Ds4CaptureWriter&) = delete;
+
+	/**
+	 * \brief Appends a report to the capture. Reports larger than
+	 * \c Ds4CaptureRecord::maxReportSize are truncated.
+	 * \param connectionType The connection the report was received on.
+	 * \param report The raw report, including the report ID.
+	 */
+	void write(ConnectionType connectionType, std::span<const uint8_t> report);
+};
+
+/**
+ * \brief Provides read-only access to the records of a capture file.
+ * The whole file is read up front so that replaying it never waits on the disk.
+ */
+class Ds4CaptureReader
+{
+	std::vector<Ds4CaptureRecord> records_;
+
+public:
+	/**
+	 * \brief Opens and reads \p path.
+	 * \param path The path of the capture file.
+	 * \throws std::runtime_error if the file cannot be read or is not a valid capture.
+	 */
+	explicit Ds4CaptureReader(const std::filesystem::path& path);
+
+	Ds4CaptureReader(const Ds4CaptureReader&) = delete;
+	Ds4CaptureReader& operator=(const Ds4CaptureReader&) = delete;
+
+	/**
+	 * \brief All complete records in the file, in the order they were captured.
+	 */
+	[[nodiscard]] std::span<const Ds4CaptureRecord> records() const;
+};
+
+/**
+ * \brief The rate at which a capture is replayed.
+ */
+enum class Ds4ReplaySpeed
+{
+	/** \brief Records are replayed with the same spacing they were captured with. */
+	realTime,
+	/** \brief Records are replayed back to back as fast as possible. */
+	unlimited
+};
@@ -1,6 +1,7 @@
 #include "pch.h"
 
 #include <chrono>
+#include <cstring>
 #include <format>
 #include <thread>
 
@@ -8,7 +9,10 @@
 #include "program.h"
 #include "DeviceProfileCache.h"
 #include "Bluetooth.h"
+#include "Crc32.h"
 #include "Ds4AutoLightColor.h"
+#include "Ds4DeviceReactor.h"
+#include "TickClock.h"
 
 // TODO: allow enabling, disabling, and remapping of individual output (and eventual virtual input) DS4 motors
 // TODO: allow enabling, disabling, and remapping of individual input XInput rumble motors
@@ -32,6 +36,11 @@ Ds4DisconnectEvent::Ds4DisconnectEvent(ConnectionType connectionType_, Reason re
 {
 }
 
+uint64_t Ds4DroppedReports::total() const
+{
+	return crcMismatch + malformed;
+}
+
 bool Ds4Device::disconnectOnIdle() const
 {
 	return settings.useProfileIdle ? profile.idle.disconnect : settings.idle.disconnect;
@@ -91,12 +100,14 @@ const std::string& Ds4Device::name() const
 }
 
 Ds4Device::Ds4Device()
-	: simulator(this)
+	: virtualPad(this),
+	  simulator(input, output, { &keyboard, &mouse, &virtualPad, this })
 {
 }
 
 Ds4Device::Ds4Device(std::shared_ptr<hid::HidInstance> device)
-	: simulator(this)
+	: virtualPad(this),
+	  simulator(input, output, { &keyboard, &mouse, &virtualPad, this })
 {
 	open(std::move(device));
 }
@@ -195,29 +206,46 @@ void Ds4Device::saveSettings()
 
 void Ds4Device::applySettings(const DeviceSettings& newSettings)
 {
-	auto lock_guard = lock();
-	settings = newSettings;
-	saveSettings();
+	{
+		auto lock_guard = lock();
+		settings = newSettings;
+		saveSettings();
+	}
+
 	applyProfile();
 }
 
 void Ds4Device::applyProfile()
 {
-	auto lock_guard = lock();
-	releaseAutoColor();
+	std::string profileName;
 
-	const std::optional<DeviceProfile> cachedProfile = Program::profileCache.getProfile(settings.profile);
+	{
+		auto lock_guard = lock();
+		profileName = settings.profile;
+	}
 
-	if (!cachedProfile.has_value())
+	// Loading, copying and compiling the profile is done without the lock
+	// so that the device thread is never blocked by it.
+	std::optional<DeviceProfile> newProfile = Program::profileCache.getProfile(profileName);
+	const bool found = newProfile.has_value();
+
+	if (!found)
 	{
-		settings.profile = {};
-		profile = DeviceProfile::defaultProfile();
+		newProfile = DeviceProfile::defaultProfile();
 	}
-	else
+
+	auto compiled = std::make_unique<CompiledProfile>(*newProfile, &simulator);
+
+	auto lock_guard = lock();
+	releaseAutoColor();
+
+	if (!found)
 	{
-		profile = *cachedProfile;
+		settings.profile = {};
 	}
 
+	profile = std::move(*newProfile);
+
 	Ds4LightOptions& lightOptions = settings.useProfileLight ? profile.light : settings.light;
 
 	if (lightOptions.automaticColor)
@@ -241,7 +269,7 @@ void Ds4Device::applyProfile()
 
 	if (this->connected())
 	{
-		simulator.applyProfile(&profile);
+		simulator.publishProfile(std::move(compiled));
 	}
 
 	idleTime.start();
@@ -268,9 +296,12 @@ void Ds4Device::closeDeviceAndResetIdle(const std::shared_ptr<hid::HidInstance>&
 
 void Ds4Device::onProfileChanged(const std::string& newName)
 {
-	auto lock_guard = lock();
-	settings.profile = newName.empty() ? std::string() : newName;
-	saveSettings();
+	{
+		auto lock_guard = lock();
+		settings.profile = newName.empty() ? std::string() : newName;
+		saveSettings();
+	}
+
 	applyProfile();
 }
 
@@ -315,6 +346,128 @@ void Ds4Device::resetWriteLatencyPeak()
 	writeLatency.resetPeak();
 }
 
+Ds4ReportStatistics Ds4Device::getReportStatistics(ConnectionType connectionType)
+{
+	auto lock_guard = lock();
+	return connectionType == +ConnectionType::usb ? usbStatistics : bluetoothStatistics;
+}
+
+Ds4DroppedReports Ds4Device::droppedReports()
+{
+	auto lock_guard = lock();
+	return droppedReports_;
+}
+
+void Ds4Device::startCapture(const std::filesystem::path& path)
+{
+	auto writer = std::make_unique<Ds4CaptureWriter>(path);
+
+	auto lock_guard = lock();
+	captureWriter = std::move(writer);
+}
+
+void Ds4Device::stopCapture()
+{
+	auto lock_guard = lock();
+	captureWriter = nullptr;
+}
+
+bool Ds4Device::capturing()
+{
+	auto lock_guard = lock();
+	return captureWriter != nullptr;
+}
+
+void Ds4Device::replay(const Ds4CaptureReader& capture, Ds4ReplaySpeed speed, const std::function<void()>& onTick)
+{
+	replay(capture.records(), speed, onTick);
+}
+
+void Ds4Device::replay(std::span<const Ds4CaptureRecord> records, Ds4ReplaySpeed speed, const std::function<void()>& onTick)
+{
+	auto lock_guard = lock();
+
+	// replayed reports would be mixed with live ones, and the live profile state thrown away
+	if (usbConnected() || bluetoothConnected())
+	{
+		throw std::runtime_error("cannot replay input on a connected device");
+	}
+
+	if (records.empty())
+	{
+		return;
+	}
+
+	// every timer reads the time each report was captured rather than the time it is replayed,
+	// so a replay behaves the same regardless of speed or how long each report takes to process
+	auto captureTime = [](const Ds4CaptureRecord& record)
+	{
+		return Stopwatch::TimePoint(duration_cast<Stopwatch::Duration>(nanoseconds(record.timestamp)));
+	};
+
+	const bool wasHeadless = simulator.headless();
+
+	// Leave the device as it would be had it never replayed anything, so that it works once opened.
+	// The profile is recompiled while still headless so that no virtual device is connected for it;
+	// that happens when the profile is applied again on connection.
+	auto restore = [&]()
+	{
+		simulator.applyProfile(std::make_unique<CompiledProfile>(profile, &simulator));
+		simulator.setHeadless(wasHeadless);
+		lastInputConnection.reset();
+	};
+
+	try
+	{
+		VirtualClock clock(captureTime(records.front()));
+		const TickClock::ScopedSource source(clock);
+
+		simulator.setHeadless(true);
+		simulator.applyProfile(std::make_unique<CompiledProfile>(profile, &simulator));
+		simulator.start();
+
+		const Stopwatch::TimePoint startTime = Stopwatch::Clock::now();
+		const uint64_t firstTimestamp = records.front().timestamp;
+
+		for (const Ds4CaptureRecord& record : records)
+		{
+			if (speed == Ds4ReplaySpeed::realTime)
+			{
+				std::this_thread::sleep_until(startTime + nanoseconds(record.timestamp - firstTimestamp));
+			}
+
+			clock.set(captureTime(record));
+			const TickClock::Tick tick;
+
+			const auto connectionType = ConnectionType::_from_integral_nothrow(record.connectionType);
+
+			if (!connectionType || !processInputReport(*connectionType, record.data()))
+			{
+				continue;
+			}
+
+			simulator.runMaps();
+
+			if (onTick)
+			{
+				onTick();
+			}
+		}
+	}
+	catch (...)
+	{
+		restore();
+		throw;
+	}
+
+	restore();
+}
+
+const XInputGamepad& Ds4Device::xinputState() const
+{
+	return simulator.xinputState();
+}
+
 void Ds4Device::closeImpl()
 {
 	auto lock_guard = lock();
@@ -330,6 +483,20 @@ void Ds4Device::close()
 {
 	running = false;
 
+	if (reactor)
+	{
+		if (reactor->isReactorThread())
+		{
+			closeImpl();
+		}
+		else
+		{
+			reactor->remove(this);
+		}
+
+		return;
+	}
+
 	if (deviceThread && deviceThread->get_id() == std::this_thread::get_id())
 	{
 		deviceThread->detach();
@@ -364,6 +531,23 @@ void Ds4Device::disconnectBluetooth(BluetoothDisconnectReason reason)
 	onDisconnect.invoke(this, Ds4DisconnectEvent(ConnectionType::bluetooth, eventReason));
 }
 
+void Ds4Device::runAction(ActionType action)
+{
+	switch (action)
+	{
+		case ActionType::bluetoothDisconnect:
+			if (bluetoothConnected())
+			{
+				disconnectBluetooth(BluetoothDisconnectReason::none);
+			}
+
+			break;
+
+		default:
+			throw std::out_of_range("invalid ActionType");
+	}
+}
+
 bool Ds4Device::openDevice(const std::shared_ptr<hid::HidInstance>& hid, bool exclusive)
 {
 	if (hid->open((exclusive ? hid::HidOpenFlags::exclusive : 0) | hid::HidOpenFlags::async))
@@ -439,6 +623,7 @@ bool Ds4Device::openBluetoothDevice(std::shared_ptr<hid::HidInstance> hid)
 	}
 
 	bluetoothDevice = std::move(hid);
+	bluetoothStatistics.reset();
 
 	setupBluetoothOutputBuffer();
 	idleTime.start();
@@ -498,6 +683,7 @@ bool Ds4Device::openUsbDevice(std::shared_ptr<hid::HidInstance> hid)
 	}
 
 	usbDevice = std::move(hid);
+	usbStatistics.reset();
 	setupUsbOutputBuffer();
 	return true;
 }
@@ -505,7 +691,7 @@ bool Ds4Device::openUsbDevice(std::shared_ptr<hid::HidInstance> hid)
 void Ds4Device::setupBluetoothOutputBuffer() const
 {
 	bluetoothDevice->outputBuffer[0] = 0x11;
-	bluetoothDevice->outputBuffer[1] = 0x80; // For HID + CRC, use 0xC0.
+	bluetoothDevice->outputBuffer[1] = 0xC0; // HID + CRC
 	bluetoothDevice->outputBuffer[3] = 0x0F;
 }
 
@@ -555,35 +741,69 @@ void Ds4Device::writeBluetooth()
 	const auto span = std::span(&bluetoothDevice->outputBuffer[btOutputOffset],
 	                            bluetoothDevice->outputBuffer.size() - btOutputOffset);
 
-	if (!output.update(span))
+	if (!output.update(span) && !bluetoothWriteRetry)
 	{
 		writeTime.start();
 		return;
 	}
 
+	writeBluetoothCrc(bluetoothDevice->outputBuffer);
+
+	bluetoothWriteRetry = false;
+
 	writeLatency.start();
 
-	// FIXME: this has the potential to loop forever
-	while (true)
+	if (!bluetoothDevice->setOutputReport())
 	{
-		if (bluetoothDevice->setOutputReport())
+		if (bluetoothDevice->nativeError() == ERROR_BUSY)
 		{
-			break;
+			// A thread servicing several controllers must not be held up by one busy
+			// Bluetooth link, so the report is sent again on the next tick instead.
+			bluetoothWriteRetry = true;
 		}
-
-		if (bluetoothDevice->nativeError() != ERROR_BUSY)
+		else
 		{
 			closeDeviceAndResetIdle(bluetoothDevice);
-			break;
 		}
-
-		std::this_thread::sleep_for(1ms);
 	}
 
 	writeLatency.stop();
 	writeTime.start();
 }
 
+namespace
+{
+	// The CRC of a Bluetooth report also covers the HID transaction header,
+	// which is not part of the report itself.
+	constexpr uint8_t bluetoothInputHeader  = 0xA1;
+	constexpr uint8_t bluetoothOutputHeader = 0xA2;
+
+	uint32_t bluetoothCrc(uint8_t header, std::span<const uint8_t> report)
+	{
+		const uint32_t crc = Crc32::compute(std::span(&header, 1));
+		return Crc32::compute(report.first(Ds4Device::bluetoothReportSize - sizeof(uint32_t)), crc);
+	}
+}
+
+bool Ds4Device::validateBluetoothCrc(std::span<const uint8_t> report)
+{
+	if (report.size() < bluetoothReportSize)
+	{
+		return false;
+	}
+
+	uint32_t expected;
+	std::memcpy(&expected, &report[bluetoothReportSize - sizeof(uint32_t)], sizeof(expected));
+
+	return bluetoothCrc(bluetoothInputHeader, report) == expected;
+}
+
+void Ds4Device::writeBluetoothCrc(std::span<uint8_t> report)
+{
+	const uint32_t crc = bluetoothCrc(bluetoothOutputHeader, report);
+	std::memcpy(&report[bluetoothReportSize - sizeof(uint32_t)], &crc, sizeof(crc));
+}
+
 void Ds4Device::onDisconnectError(const std::shared_ptr<hid::HidInstance>& device, ConnectionType connectionType)
 {
 	const size_t nativeError = device->nativeError();
@@ -595,8 +815,84 @@ void Ds4Device::onDisconnectError(const std::shared_ptr<hid::HidInstance>& devic
 	onDisconnect.invoke(this, Ds4DisconnectEvent(connectionType, reason, nativeError));
 }
 
-bool Ds4Device::run()
+bool Ds4Device::processInputReport(ConnectionType connectionType, std::span<const uint8_t> report)
 {
+	const std::span<const uint8_t> data = receiveInputReport(connectionType, report);
+
+	if (data.empty() || !isNewInputReport(connectionType, Ds4Input::decodeTimestamp(data)))
+	{
+		return false;
+	}
+
+	lastInputConnection = connectionType;
+	lastInputTimestamp  = Ds4Input::decodeTimestamp(data);
+
+	input.update(data);
+	return true;
+}
+
+std::span<const uint8_t> Ds4Device::receiveInputReport(ConnectionType connectionType, std::span<const uint8_t> report)
+{
+	if (captureWriter)
+	{
+		captureWriter->write(connectionType, report);
+	}
+
+	size_t inputOffset;
+
+	if (connectionType == +ConnectionType::usb)
+	{
+		inputOffset = 1;
+	}
+	else
+	{
+		if (report.size() < bluetoothReportSize || report[0] != 0x11)
+		{
+			++droppedReports_.malformed;
+			return {};
+		}
+
+		if (!validateBluetoothCrc(report))
+		{
+			++droppedReports_.crcMismatch;
+			return {};
+		}
+
+		inputOffset = 3;
+	}
+
+	if (report.size() < inputOffset + Ds4Input::minimumReportSize)
+	{
+		++droppedReports_.malformed;
+		return {};
+	}
+
+	const std::span<const uint8_t> data = report.subspan(inputOffset);
+
+	Ds4ReportStatistics& statistics = connectionType == +ConnectionType::usb ? usbStatistics : bluetoothStatistics;
+	statistics.push(Ds4Input::decodeFrameCount(data), Ds4Input::decodeTimestamp(data), TickClock::now());
+
+	return data;
+}
+
+bool Ds4Device::isNewInputReport(ConnectionType connectionType, uint16_t timestamp) const
+{
+	// Reports over a single connection always arrive in order.
+	if (!lastInputConnection.has_value() || *lastInputConnection == connectionType)
+	{
+		return true;
+	}
+
+	// Signed difference accounts for the timestamp wrapping. Since the other connection is drained
+	// every tick, a report behind the last one used is a duplicate of one that already was, never
+	// input that has yet to be seen, so on failover it is rejected rather than replayed.
+	return static_cast<int16_t>(timestamp - lastInputTimestamp) > 0;
+}
+
+bool Ds4Device::run(std::array<std::shared_ptr<hid::HidInstance>, 2>& devices)
+{
+	const TickClock::Tick tick;
+
 	// HACK: make this class manage the light state
 	output.lightColor = activeLight.color;
 
@@ -614,13 +910,7 @@ bool Ds4Device::run()
 	const bool lastChargingState = charging();
 	const uint8_t lastBatteryLevel = battery();
 
-	// cache
-	const bool usb = usbConnected();
-	const bool bluetooth = bluetoothConnected();
-
-	const ConnectionType preferredConnection = Program::settings.preferredConnection;
-	const bool useUsb = usb && (preferredConnection == +ConnectionType::usb || !bluetooth);
-	const bool useBluetooth = bluetooth && (preferredConnection == +ConnectionType::bluetooth || !usb);
+	const std::optional<ConnectionType> primary = primaryConnection();
 
 	bool dataReceived = false;
 
@@ -669,71 +959,101 @@ bool Ds4Device::run()
 		return !asyncReadInProgress;
 	};
 
-	if (useUsb)
+	auto disconnected = [&](const std::shared_ptr<hid::HidInstance>& device, ConnectionType connectionType)
 	{
-		writeUsbAsync();
-
-		if (!usbDevice->isOpen())
+		// the other connection's timestamps can't be compared to this one's once it is gone,
+		// so the next report received over it is used as-is
+		if (lastInputConnection == connectionType)
 		{
-			onDisconnectError(usbDevice, ConnectionType::usb);
+			lastInputConnection.reset();
 		}
-		else if (asyncRead(usbDevice.get()))
-		{
-			dataReceived = true;
 
-			constexpr auto usbInputOffset = 1;
-			const auto span = std::span(&usbDevice->inputBuffer[usbInputOffset],
-			                            usbDevice->inputBuffer.size() - usbInputOffset);
+		onDisconnectError(device, connectionType);
+	};
+
+	// Returns true if a report is waiting in the device's input buffer.
+	auto readDevice = [&](const std::shared_ptr<hid::HidInstance>& device, ConnectionType connectionType) -> bool
+	{
+		if (!device->isOpen())
+		{
+			disconnected(device, connectionType);
+			return false;
+		}
 
-			input.update(span);
+		if (asyncRead(device.get()) && device->isOpen())
+		{
+			return true;
 		}
-		else if (!usbDevice->isOpen())
+
+		if (!device->isOpen())
 		{
-			onDisconnectError(usbDevice, ConnectionType::usb);
+			disconnected(device, connectionType);
 		}
+
+		return false;
+	};
+
+	if (primary == +ConnectionType::usb)
+	{
+		writeUsbAsync();
 	}
-	else if (useBluetooth)
+	else if (primary == +ConnectionType::bluetooth)
 	{
 		writeBluetooth();
+	}
+
+	// When both connections are open, both are read every tick so that input keeps flowing if one stalls.
+	// Only one report is used per tick. Once one has been, everything waiting on the other connection
+	// is drained and discarded, since the primary connection delivers the same reports; otherwise they
+	// would pile up and be replayed if the primary connection failed.
+	devices = activeDevices(primary);
 
-		if (!bluetoothDevice->isOpen())
+	for (const std::shared_ptr<hid::HidInstance>& device : devices)
+	{
+		if (device == nullptr)
 		{
-			onDisconnectError(bluetoothDevice, ConnectionType::bluetooth);
+			continue;
 		}
-		else if (asyncRead(bluetoothDevice.get()))
+
+		const ConnectionType connectionType = device == usbDevice ? ConnectionType::usb : ConnectionType::bluetooth;
+
+		while (readDevice(device, connectionType))
 		{
-			if (bluetoothDevice->inputBuffer[0] == 0x11)
+			if (dataReceived)
 			{
-				dataReceived = true;
+				receiveInputReport(connectionType, device->inputBuffer);
+				continue;
+			}
 
-				constexpr auto btInputOffset = 3;
-				const auto span = std::span(&bluetoothDevice->inputBuffer[btInputOffset],
-				                            bluetoothDevice->inputBuffer.size() - btInputOffset);
+			dataReceived = processInputReport(connectionType, device->inputBuffer);
 
-				input.update(span);
+			if (dataReceived)
+			{
+				// leave the rest of this connection's reports for the next tick
+				break;
 			}
 		}
-		else if (!bluetoothDevice->isOpen())
-		{
-			onDisconnectError(bluetoothDevice, ConnectionType::bluetooth);
-		}
 	}
 
-	const float lx = input.getAxis(Ds4Axes::leftStickX, std::nullopt);
-	const float ly = input.getAxis(Ds4Axes::leftStickY, std::nullopt);
-	const float ls = std::sqrt(lx * lx + ly * ly);
+	if (input.changedFields & (Ds4InputFields::leftStick | Ds4InputFields::rightStick))
+	{
+		const float lx = input.getAxis(Ds4Axes::leftStickX, std::nullopt);
+		const float ly = input.getAxis(Ds4Axes::leftStickY, std::nullopt);
+		const float ls = std::sqrt(lx * lx + ly * ly);
 
-	const float rx = input.getAxis(Ds4Axes::rightStickX, std::nullopt);
-	const float ry = input.getAxis(Ds4Axes::rightStickY, std::nullopt);
-	const float rs = std::sqrt(rx * rx + ry * ry);
+		const float rx = input.getAxis(Ds4Axes::rightStickX, std::nullopt);
+		const float ry = input.getAxis(Ds4Axes::rightStickY, std::nullopt);
+		const float rs = std::sqrt(rx * rx + ry * ry);
+
+		sticksDeflected = ls >= 0.25f || rs >= 0.25f;
+	}
 
 	// TODO: gyro/accel - definitely needs to be configurable
-	if (input.buttonsChanged || input.heldButtons ||
-	    ls >= 0.25f || rs >= 0.25f)
+	if (input.buttonsChanged || input.heldButtons || sticksDeflected)
 	{
 		idleTime.start();
 	}
-	else if (disconnectOnIdle() && useBluetooth && !charging() && isIdle())
+	else if (disconnectOnIdle() && primary == +ConnectionType::bluetooth && !charging() && isIdle())
 	{
 		disconnectBluetooth(BluetoothDisconnectReason::idle);
 	}
@@ -823,43 +1143,222 @@ bool Ds4Device::run()
 	else
 	{
 		input.updateChangedState();
-		simulator.runPersistent();
+
+		const std::optional<Stopwatch::Duration> persistentTime = simulator.timeUntilUpdate();
+
+		if (persistentTime.has_value() && *persistentTime <= Stopwatch::Duration::zero())
+		{
+			simulator.runPersistent();
+		}
 	}
 
 	return dataReceived;
 }
 
-void Ds4Device::controllerThread()
+std::optional<ConnectionType> Ds4Device::primaryConnection()
 {
-	simulator.start();
-	readLatency.start();
-	idleTime.start();
-	writeTime.start();
+	const bool usb = usbConnected();
+	const bool bluetooth = bluetoothConnected();
 
-	while (connected() && running)
+	if (!usb || !bluetooth)
 	{
-		bool dataReceived;
+		if (usb)
+		{
+			return ConnectionType::usb;
+		}
 
+		if (bluetooth)
 		{
-			auto lock_guard = lock();
-			dataReceived = run();
+			return ConnectionType::bluetooth;
 		}
 
-		if (!dataReceived)
+		return std::nullopt;
+	}
+
+	const ConnectionType preferred = Program::settings.preferredConnection;
+	const ConnectionType other = preferred == +ConnectionType::usb ? ConnectionType::bluetooth : ConnectionType::usb;
+
+	auto stalled = [&](ConnectionType connectionType) -> bool
+	{
+		const Ds4ReportStatistics& statistics = connectionType == +ConnectionType::usb ? usbStatistics : bluetoothStatistics;
+		const std::optional<Stopwatch::TimePoint> lastReport = statistics.lastReportTime();
+
+		return !lastReport.has_value() || TickClock::now() - *lastReport > settings.latencyThreshold;
+	};
+
+	return stalled(preferred) && !stalled(other) ? other : preferred;
+}
+
+std::array<std::shared_ptr<hid::HidInstance>, 2> Ds4Device::activeDevices(std::optional<ConnectionType> primary)
+{
+	if (!primary.has_value())
+	{
+		return {};
+	}
+
+	std::array<std::shared_ptr<hid::HidInstance>, 2> result;
+
+	if (*primary == +ConnectionType::usb)
+	{
+		result[0] = usbDevice;
+		result[1] = bluetoothConnected() ? bluetoothDevice : nullptr;
+	}
+	else
+	{
+		result[0] = bluetoothDevice;
+		result[1] = usbConnected() ? usbDevice : nullptr;
+	}
+
+	return result;
+}
+
+std::optional<Stopwatch::Duration> Ds4Device::timeUntilUpdate() const
+{
+	std::optional<Stopwatch::Duration> result = simulator.timeUntilUpdate();
+
+	auto earliest = [&](Stopwatch::Duration value)
+	{
+		value = std::max(value, Stopwatch::Duration::zero());
+
+		if (!result.has_value() || value < *result)
+		{
+			result = value;
+		}
+	};
+
+	if (!isIdle())
+	{
+		const Stopwatch::Duration remaining = idleTimeout() - idleTime.elapsed();
+
+		if (disconnectOnIdle() && bluetoothDevice != nullptr && bluetoothDevice->isOpen() && !charging())
 		{
-			std::this_thread::sleep_for(1ms);
+			earliest(remaining);
+		}
+
+		if (activeLight.idleFade)
+		{
+			// 8 bits per color channel means there's no point updating the fade more often than this.
+			earliest(std::min(remaining, Stopwatch::Duration(idleTimeout()) / 256));
 		}
 	}
 
+	return result;
+}
+
+void Ds4Device::waitForInput(std::span<const std::shared_ptr<hid::HidInstance>> devices, Stopwatch::Duration timeout)
+{
+	timeout = std::clamp<Stopwatch::Duration>(timeout, Stopwatch::Duration::zero(), maxInputWait);
+
+	if (timeout == Stopwatch::Duration::zero())
+	{
+		return;
+	}
+
+	std::array<hid::HidInstance*, maxWaitableDevices> waitable {};
+	size_t count = 0;
+
+	for (const std::shared_ptr<hid::HidInstance>& device : devices)
+	{
+		if (device == nullptr)
+		{
+			continue;
+		}
+
+		if (count == waitable.size())
+		{
+			std::this_thread::sleep_for(std::min<Stopwatch::Duration>(timeout, 1ms));
+			return;
+		}
+
+		// Without a read in flight there's nothing to be woken by, so one is issued here.
+		// If that fails, the device is left for the next run to deal with.
+		if (!device->isOpen() || (!device->asyncReadPending() && !device->readAsync()))
+		{
+			return;
+		}
+
+		waitable[count++] = device.get();
+	}
+
+	if (count == 0)
+	{
+		return;
+	}
+
+	hid::HidInstance::waitForAnyAsyncRead(std::span(waitable.data(), count),
+	                                      static_cast<uint32_t>(ceil<milliseconds>(timeout).count()));
+}
+
+bool Ds4Device::keepRunning()
+{
+	return connected() && running;
+}
+
+void Ds4Device::beginRunning()
+{
+	simulator.start();
+	readLatency.start();
+	idleTime.start();
+	writeTime.start();
+}
+
+bool Ds4Device::runOnce(std::array<std::shared_ptr<hid::HidInstance>, 2>& devices, Stopwatch::Duration& timeout)
+{
+	auto lock_guard = lock();
+
+	// run fills devices with references which keep them alive through the wait
+	// if they get replaced by another thread. The wait itself must not hold the lock.
+	if (run(devices))
+	{
+		return true;
+	}
+
+	timeout = timeUntilUpdate().value_or(maxInputWait);
+	return false;
+}
+
+void Ds4Device::finishRunning()
+{
 	closeImpl();
 	onDeviceClose.invoke(this);
 }
 
-void Ds4Device::start()
+void Ds4Device::controllerThread()
+{
+	beginRunning();
+
+	while (keepRunning())
+	{
+		std::array<std::shared_ptr<hid::HidInstance>, 2> devices;
+		Stopwatch::Duration timeout;
+
+		if (runOnce(devices, timeout))
+		{
+			continue;
+		}
+
+		waitForInput(devices, timeout);
+	}
+
+	finishRunning();
+}
+
+void Ds4Device::start(Ds4DeviceReactor* reactor_)
 {
-	if (deviceThread == nullptr)
+	if (deviceThread != nullptr || reactor != nullptr)
+	{
+		return;
+	}
+
+	running = true;
+
+	if (reactor_)
+	{
+		reactor = reactor_;
+		reactor->add(this);
+	}
+	else
 	{
-		running = true;
 		deviceThread = std::make_unique<std::thread>(&Ds4Device::controllerThread, this);
 	}
 }
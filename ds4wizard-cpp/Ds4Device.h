@@ -1,21 +1,30 @@
 #pragma once
 
+#include <array>
 #include <chrono>
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <thread>
 
 #include "DeviceSettings.h"
 #include "DeviceProfile.h"
+#include "Ds4Capture.h"
 #include "hid_instance.h"
 #include "Stopwatch.h"
 #include "Ds4Input.h"
 #include "Ds4Output.h"
+#include "Ds4ReportStatistics.h"
 #include "Event.h"
 
 #include "Latency.h"
 #include "InputSimulator.h"
+#include "KeyboardSimulator.h"
 #include "MacAddress.h"
+#include "MouseSimulator.h"
+#include "VirtualXInputPad.h"
+
+class Ds4DeviceReactor;
 
 class Ds4ConnectEvent
 {
@@ -57,17 +66,49 @@ public:
 	Ds4DisconnectEvent(ConnectionType connectionType_, Reason reason_, std::optional<size_t> nativeError_ = std::nullopt);
 };
 
-class Ds4Device
+/**
+ * \brief Counts of input reports that were received but discarded.
+ */
+struct Ds4DroppedReports
+{
+	/**
+	 * \brief Bluetooth reports whose CRC did not match their contents.
+	 */
+	uint64_t crcMismatch = 0;
+
+	/**
+	 * \brief Reports that were too short or had an unexpected report ID.
+	 */
+	uint64_t malformed = 0;
+
+	[[nodiscard]] uint64_t total() const;
+};
+
+class Ds4Device : public IDeviceActionSink
 {
+	friend class Ds4DeviceReactor;
+
 private:
 	bool peakedLatencyThreshold = false;
 	std::string macAddress_;
 	std::string safeMacAddress_;
 
+	/**
+	 * \brief The longest the controller thread will block waiting for input
+	 * before re-checking if it should still be running.
+	 */
+	static constexpr std::chrono::milliseconds maxInputWait { 100 };
+
 	bool running = false;
 	std::recursive_mutex sync_lock;
 
 	Stopwatch idleTime {};
+
+	/**
+	 * \brief Indicates if either stick was far enough from center to reset \c idleTime
+	 * as of the last report in which a stick moved.
+	 */
+	bool sticksDeflected = false;
 	Stopwatch writeTime {};
 
 	inline static const Ds4Color fadeColor {};
@@ -77,8 +118,23 @@ private:
 	Latency readLatency;
 	Latency writeLatency;
 
+	Ds4ReportStatistics usbStatistics;
+	Ds4ReportStatistics bluetoothStatistics;
+
+	/**
+	 * \brief The connection and device timestamp of the last report used to update \c input.
+	 * When both connections are open, reports are deduplicated against this.
+	 */
+	std::optional<ConnectionType> lastInputConnection;
+	uint16_t lastInputTimestamp = 0;
+
 	std::unique_ptr<std::thread> deviceThread = nullptr;
 
+	/**
+	 * \brief The reactor servicing this device in place of \c deviceThread, if any.
+	 */
+	Ds4DeviceReactor* reactor = nullptr;
+
 	std::shared_ptr<hid::HidInstance> usbDevice;
 	std::shared_ptr<hid::HidInstance> bluetoothDevice;
 	MacAddress macAddressBytes {};
@@ -89,8 +145,22 @@ private:
 	std::chrono::microseconds idleTimeout() const;
 	bool isIdle() const;
 
+	KeyboardSimulator keyboard;
+	MouseSimulator mouse;
+	VirtualXInputPad virtualPad;
+
 	InputSimulator simulator;
 
+	std::unique_ptr<Ds4CaptureWriter> captureWriter;
+
+	Ds4DroppedReports droppedReports_ {};
+
+	/**
+	 * \brief Indicates that the last Bluetooth output report could not be sent because the
+	 * device was busy, so it must be sent again even if the output state has not changed since.
+	 */
+	bool bluetoothWriteRetry = false;
+
 	// TODO: rather than storing a boolean, implement a run-once, resettable callback
 	bool notifiedLow = false;
 	// TODO: rather than storing a boolean, implement a run-once, resettable callback
@@ -105,6 +175,11 @@ public:
 
 	static constexpr size_t usbInputReportSize = 64;
 
+	/**
+	 * \brief Size of Bluetooth input and output report 0x11, including the report ID and trailing CRC.
+	 */
+	static constexpr size_t bluetoothReportSize = 78;
+
 	Event<Ds4Device> onDeviceClose;
 	Event<Ds4Device, Ds4ConnectEvent> onConnect;
 	Event<Ds4Device, size_t> onWirelessOperationalModeFailure;
@@ -146,7 +221,7 @@ public:
 
 	Ds4Device();
 	explicit Ds4Device(std::shared_ptr<hid::HidInstance> device);
-	~Ds4Device();
+	~Ds4Device() override;
 
 	static MacAddress getMacAddress(const std::shared_ptr<hid::HidInstance>& device);
 
@@ -160,6 +235,63 @@ public:
 	void resetReadLatencyPeak();
 	void resetWriteLatencyPeak();
 
+	/**
+	 * \brief Gets frame counter based statistics of the input reports received over a connection.
+	 * \param connectionType The connection to get statistics for.
+	 */
+	Ds4ReportStatistics getReportStatistics(ConnectionType connectionType);
+
+	/**
+	 * \brief Gets the number of input reports discarded since this instance was created.
+	 */
+	Ds4DroppedReports droppedReports();
+
+	/**
+	 * \brief Starts recording every raw input report received from this device.
+	 * If a capture is already in progress, it is stopped first.
+	 * \param path The capture file to append to.
+	 * \throws std::runtime_error if the file cannot be opened.
+	 */
+	void startCapture(const std::filesystem::path& path);
+
+	/**
+	 * \brief Stops recording input reports.
+	 */
+	void stopCapture();
+
+	/**
+	 * \brief Indicates if input reports are being recorded.
+	 */
+	bool capturing();
+
+	/**
+	 * \brief Feeds a capture through the input pipeline in place of a physical device.
+	 * Simulated output is computed headlessly and never reaches the system.
+	 * Timers run on the capture's own timestamps, so the result does not depend on \p speed.
+	 * This instance must not have an open connection; use a separate \c Ds4Device to replay alongside
+	 * a connected one. Headless mode is restored and the profile recompiled afterward.
+	 * \throws std::runtime_error if a connection is open.
+	 * \param capture The capture to replay.
+	 * \param speed The rate at which to replay \p capture.
+	 * \param onTick Optional callback invoked after each replayed report, e.g. to inspect \c input or \c xinputState.
+	 */
+	void replay(const Ds4CaptureReader& capture, Ds4ReplaySpeed speed, const std::function<void()>& onTick = nullptr);
+
+	/**
+	 * \brief Feeds input reports through the input pipeline in place of a physical device,
+	 * e.g. reports generated for a benchmark. \sa replay(const Ds4CaptureReader&, Ds4ReplaySpeed, const std::function<void()>&)
+	 * \param records The reports to replay, in order.
+	 * \param speed The rate at which to replay \p records.
+	 * \param onTick Optional callback invoked after each replayed report.
+	 * \throws std::runtime_error if a connection is open.
+	 */
+	void replay(std::span<const Ds4CaptureRecord> records, Ds4ReplaySpeed speed, const std::function<void()>& onTick = nullptr);
+
+	/**
+	 * \brief The simulated XInput state as of the last tick.
+	 */
+	const XInputGamepad& xinputState() const;
+
 private:
 	void closeImpl();
 
@@ -182,6 +314,12 @@ public:
 
 	void disconnectBluetooth(BluetoothDisconnectReason reason);
 
+	/**
+	 * \brief Performs a special action on behalf of an input map of the active profile.
+	 * \param action The action to perform.
+	 */
+	void runAction(ActionType action) override;
+
 	static bool openDevice(const std::shared_ptr<hid::HidInstance>& hid, bool exclusive);
 
 	bool openBluetoothDevice(std::shared_ptr<hid::HidInstance> hid);
@@ -192,10 +330,115 @@ private:
 	void setupUsbOutputBuffer() const;
 	void writeUsbAsync();
 	void writeBluetooth();
+
+	/**
+	 * \brief Checks the CRC of a Bluetooth report 0x11.
+	 * \param report The raw report, including the report ID.
+	 * \return \c true if \p report is at least \c bluetoothReportSize bytes and its CRC matches.
+	 */
+	static bool validateBluetoothCrc(std::span<const uint8_t> report);
+
+	/**
+	 * \brief Computes and stores the CRC of a Bluetooth output report 0x11.
+	 * \param report The raw report, including the report ID, of at least \c bluetoothReportSize bytes.
+	 */
+	static void writeBluetoothCrc(std::span<uint8_t> report);
 	void onDisconnectError(const std::shared_ptr<hid::HidInstance>& device, ConnectionType connectionType);
-	bool run();
+
+	/**
+	 * \brief Records (if capturing) and parses a raw input report.
+	 * \param connectionType The connection \p report was received on.
+	 * \param report The raw report, including the report ID.
+	 * \return \c true if \p report was a full input report newer than the last and \c input was updated.
+	 */
+	bool processInputReport(ConnectionType connectionType, std::span<const uint8_t> report);
+
+	/**
+	 * \brief Records (if capturing), validates and collects statistics of a raw input report
+	 * without using it to update \c input. \sa processInputReport
+	 * \param connectionType The connection \p report was received on.
+	 * \param report The raw report, including the report ID.
+	 * \return The input data of \p report, or an empty span if it is malformed.
+	 */
+	std::span<const uint8_t> receiveInputReport(ConnectionType connectionType, std::span<const uint8_t> report);
+
+	/**
+	 * \brief Determines if a report is newer than the last one used to update \c input,
+	 * i.e. that it is neither a duplicate received over the other connection nor older than that.
+	 * \param connectionType The connection the report was received on.
+	 * \param timestamp The device timestamp of the report.
+	 */
+	bool isNewInputReport(ConnectionType connectionType, uint16_t timestamp) const;
+
+	/**
+	 * \brief Runs one tick of the device. \sa runOnce
+	 * \param devices Receives the devices which were read from, as returned by \c activeDevices.
+	 */
+	bool run(std::array<std::shared_ptr<hid::HidInstance>, 2>& devices);
+
+	/**
+	 * \brief Gets the connection output is written to and input is read from first.
+	 * This is the preferred connection unless it has stopped delivering reports for
+	 * longer than \c DeviceSettings::latencyThreshold while the other has not.
+	 * \return The primary connection, or \c std::nullopt if neither is open.
+	 */
+	std::optional<ConnectionType> primaryConnection();
+
+	/**
+	 * \brief Gets the open devices in the order they are read from, primary connection first.
+	 * Unused entries are \c nullptr.
+	 * \param primary The connection returned by \c primaryConnection.
+	 */
+	std::array<std::shared_ptr<hid::HidInstance>, 2> activeDevices(std::optional<ConnectionType> primary);
+
+	/**
+	 * \brief Gets the time remaining until the next timed event (rapid fire, rumble, idle timeout, light fade)
+	 * needs to be processed in the absence of new input.
+	 */
+	std::optional<Stopwatch::Duration> timeUntilUpdate() const;
+
+	/**
+	 * \brief The most devices \c waitForInput can block on at once.
+	 * Beyond this, it falls back to polling.
+	 */
+	static constexpr size_t maxWaitableDevices = hid::HidInstance::maxWaitCount;
+
+	/**
+	 * \brief Blocks until any of \p devices has an input report ready or \p timeout elapses.
+	 * \param devices The devices to wait on. \c nullptr entries are ignored.
+	 * \param timeout The maximum amount of time to wait, which is further limited by \c maxInputWait.
+	 */
+	static void waitForInput(std::span<const std::shared_ptr<hid::HidInstance>> devices, Stopwatch::Duration timeout);
+
+	/**
+	 * \brief Indicates if the device is still connected and has not been told to stop.
+	 */
+	bool keepRunning();
+
+	/**
+	 * \brief Resets timers before the first call to \c runOnce.
+	 */
+	void beginRunning();
+
+	/**
+	 * \brief Services the device once, processing at most one input report.
+	 * \param devices If no report was processed, receives the devices to wait on before the next call.
+	 * \param timeout If no report was processed, receives the longest time to wait before the next call.
+	 * \return \c true if a report was processed, in which case the device should be run again without waiting.
+	 */
+	bool runOnce(std::array<std::shared_ptr<hid::HidInstance>, 2>& devices, Stopwatch::Duration& timeout);
+
+	/**
+	 * \brief Closes the device once it has stopped running and invokes \c onDeviceClose.
+	 */
+	void finishRunning();
+
 	void controllerThread();
 
 public:
-	void start();
+	/**
+	 * \brief Starts servicing the device.
+	 * \param reactor The reactor to service the device with, or \c nullptr to service it with its own thread.
+	 */
+	void start(Ds4DeviceReactor* reactor = nullptr);
 };
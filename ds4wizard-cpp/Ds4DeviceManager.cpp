@@ -321,7 +321,7 @@ bool Ds4DeviceManager::handleDevice(const std::shared_ptr<hid::HidInstance>& hid
 
 			auto args = std::make_shared<DeviceOpenedEventArgs>(device, true);
 			deviceOpened.invoke(this, args);
-			device->start();
+			device->start(Program::settings.sharedDeviceThread ? &reactor : nullptr);
 		}
 		else
 		{
@@ -7,6 +7,7 @@
 
 #include <hid_instance.h>
 #include "Ds4Device.h"
+#include "Ds4DeviceReactor.h"
 #include "Event.h"
 
 class DeviceOpenedEventArgs
@@ -50,6 +51,11 @@ class Ds4DeviceManager
 	std::recursive_mutex sync_lock, devices_lock;
 	std::unordered_map<std::wstring, std::deque<EventToken>> tokens;
 
+	/**
+	 * \brief Services devices when \c Settings::sharedDeviceThread is enabled.
+	 */
+	Ds4DeviceReactor reactor;
+
 public:
 	std::map<std::wstring, std::shared_ptr<Ds4Device>> devices;
 
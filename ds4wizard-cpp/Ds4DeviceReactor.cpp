@@ -0,0 +1,164 @@
+#include "pch.h"
+
+#include <algorithm>
+
+#include "Ds4DeviceReactor.h"
+#include "Ds4Device.h"
+
+Ds4DeviceReactor::~Ds4DeviceReactor()
+{
+	{
+		std::lock_guard lock(sync_lock);
+		stopping = true;
+	}
+
+	condition.notify_all();
+
+	if (reactorThread_ && reactorThread_->joinable())
+	{
+		reactorThread_->join();
+	}
+}
+
+void Ds4DeviceReactor::add(Ds4Device* device)
+{
+	{
+		std::lock_guard lock(sync_lock);
+
+		added.push_back(device);
+
+		if (reactorThread_ == nullptr)
+		{
+			reactorThread_ = std::make_unique<std::thread>(&Ds4DeviceReactor::run, this);
+		}
+	}
+
+	condition.notify_all();
+}
+
+void Ds4DeviceReactor::remove(Ds4Device* device)
+{
+	std::unique_lock lock(sync_lock);
+
+	// the reactor thread notices the device has stopped on its next pass,
+	// which is at most Ds4Device::maxInputWait away
+	condition.wait(lock, [&] { return stopping || !contains(device); });
+}
+
+bool Ds4DeviceReactor::isReactorThread() const
+{
+	return reactorThread_ != nullptr && reactorThread_->get_id() == std::this_thread::get_id();
+}
+
+bool Ds4DeviceReactor::contains(const Ds4Device* device) const
+{
+	return device == retiring ||
+	       std::ranges::find(added, device) != added.end() ||
+	       std::ranges::find(devices, device, &ServicedDevice::device) != devices.end();
+}
+
+bool Ds4DeviceReactor::ServicedDevice::shouldRun(Stopwatch::TimePoint now) const
+{
+	if (ready || now >= due)
+	{
+		return true;
+	}
+
+	// non-consuming; the device itself collects the report when it runs
+	return std::ranges::any_of(waitable, [](const std::shared_ptr<hid::HidInstance>& hid)
+	{
+		return hid != nullptr && hid->waitForAsyncRead(0);
+	});
+}
+
+void Ds4DeviceReactor::run()
+{
+	std::vector<std::shared_ptr<hid::HidInstance>> waitable;
+
+	while (true)
+	{
+		{
+			std::unique_lock lock(sync_lock);
+			condition.wait(lock, [this] { return stopping || !added.empty() || !devices.empty(); });
+
+			if (stopping)
+			{
+				break;
+			}
+
+			for (Ds4Device* device : added)
+			{
+				device->beginRunning();
+				devices.push_back({ .device = device });
+			}
+
+			added.clear();
+		}
+
+		bool dataReceived = false;
+		const Stopwatch::TimePoint now = Stopwatch::Clock::now();
+		Stopwatch::TimePoint nextDue = now + Ds4Device::maxInputWait;
+
+		waitable.clear();
+
+		for (size_t i = 0; i < devices.size();)
+		{
+			ServicedDevice& serviced = devices[i];
+			Ds4Device* device = serviced.device;
+
+			if (!device->keepRunning())
+			{
+				{
+					std::lock_guard lock(sync_lock);
+					devices.erase(devices.begin() + static_cast<ptrdiff_t>(i));
+					retiring = device;
+				}
+
+				// the device may be destroyed by its close event, so it must not be used past this point
+				device->finishRunning();
+
+				{
+					std::lock_guard lock(sync_lock);
+					retiring = nullptr;
+				}
+
+				condition.notify_all();
+				continue;
+			}
+
+			++i;
+
+			// a device with nothing to read and nothing due is left alone, so that
+			// one busy device does not cost every other device a pass of its own
+			if (serviced.shouldRun(now))
+			{
+				Stopwatch::Duration deviceTimeout;
+				serviced.ready = device->runOnce(serviced.waitable, deviceTimeout);
+
+				if (serviced.ready)
+				{
+					dataReceived = true;
+					continue;
+				}
+
+				serviced.due = now + deviceTimeout;
+			}
+
+			nextDue = std::min(nextDue, serviced.due);
+
+			for (const std::shared_ptr<hid::HidInstance>& hid : serviced.waitable)
+			{
+				if (hid != nullptr)
+				{
+					waitable.push_back(hid);
+				}
+			}
+		}
+
+		// as with a device's own thread, keep reading while reports are arriving
+		if (!dataReceived && !devices.empty())
+		{
+			Ds4Device::waitForInput(waitable, std::max(Stopwatch::Duration::zero(), nextDue - Stopwatch::Clock::now()));
+		}
+	}
+}
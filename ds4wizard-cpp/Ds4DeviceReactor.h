@@ -0,0 +1,112 @@
+#pragma once
+
+#include <array>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Stopwatch.h"
+
+namespace hid
+{
+	class HidInstance;
+}
+
+class Ds4Device;
+
+/**
+ * \brief Services any number of devices from a single thread in place of a thread per device.
+ * Each pass runs, in the order they were added, only the devices with an input report ready or
+ * a timed event due, then blocks until the next of either. A device is only ever run by this thread,
+ * so its reports are processed in order just as they would be by its own thread.
+ * \sa Ds4Device::start, Settings::sharedDeviceThread
+ */
+class Ds4DeviceReactor
+{
+	/**
+	 * \brief A device being serviced, and what it is waiting on as of its last run.
+	 */
+	struct ServicedDevice
+	{
+		Ds4Device* device = nullptr;
+
+		/**
+		 * \brief The connections whose input reports the device is waiting on.
+		 */
+		std::array<std::shared_ptr<hid::HidInstance>, 2> waitable;
+
+		/**
+		 * \brief When the device must be run again even if no input report arrives.
+		 */
+		Stopwatch::TimePoint due {};
+
+		/**
+		 * \brief Indicates that the device must be run on the next pass regardless, e.g. because
+		 * it was just added or is still receiving reports.
+		 */
+		bool ready = true;
+
+		/**
+		 * \brief Indicates if the device has an input report waiting, its deadline has passed, or \c ready is set.
+		 * \param now The time to compare the deadline against.
+		 */
+		[[nodiscard]] bool shouldRun(Stopwatch::TimePoint now) const;
+	};
+
+	std::mutex sync_lock;
+	std::condition_variable condition;
+	std::unique_ptr<std::thread> reactorThread_;
+	bool stopping = false;
+
+	/**
+	 * \brief Devices waiting to be picked up by the reactor thread.
+	 */
+	std::vector<Ds4Device*> added;
+
+	/**
+	 * \brief Devices being serviced. Only modified by the reactor thread, and only while holding \c sync_lock.
+	 */
+	std::vector<ServicedDevice> devices;
+
+	/**
+	 * \brief A device which has stopped and is being closed by the reactor thread, if any.
+	 */
+	Ds4Device* retiring = nullptr;
+
+public:
+	Ds4DeviceReactor() = default;
+	~Ds4DeviceReactor();
+
+	Ds4DeviceReactor(const Ds4DeviceReactor&) = delete;
+	Ds4DeviceReactor& operator=(const Ds4DeviceReactor&) = delete;
+
+	/**
+	 * \brief Starts servicing a device, starting the reactor thread if necessary.
+	 * Once the device stops running, it is closed and its \c Ds4Device::onDeviceClose is invoked
+	 * from the reactor thread, as it would be from its own thread.
+	 */
+	void add(Ds4Device* device);
+
+	/**
+	 * \brief Blocks until a device which has been told to stop is no longer being serviced.
+	 * Returns immediately if \p device was never added or has already been closed.
+	 * Must not be called from the reactor thread.
+	 */
+	void remove(Ds4Device* device);
+
+	/**
+	 * \brief Indicates if the calling thread is the reactor thread.
+	 */
+	[[nodiscard]] bool isReactorThread() const;
+
+private:
+	void run();
+
+	/**
+	 * \brief Determines if \p device is waiting to be serviced, being serviced, or being closed.
+	 * \c sync_lock must be held.
+	 */
+	[[nodiscard]] bool contains(const Ds4Device* device) const;
+};
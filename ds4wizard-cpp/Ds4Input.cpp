@@ -1,6 +1,195 @@
 #include "pch.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
 #include "Ds4Input.h"
 
+namespace
+{
+	/**
+	 * \brief Byte offsets of the fields of an input report, relative to the start
+	 * of the input data (i.e. after the report ID, and after the Bluetooth header).
+	 */
+	namespace Ds4InputReportLayout
+	{
+		constexpr size_t leftStick    = 0;
+		constexpr size_t rightStick   = 2;
+		constexpr size_t buttons      = 4;
+		constexpr size_t frameCount   = 6;
+		constexpr size_t leftTrigger  = 7;
+		constexpr size_t rightTrigger = 8;
+		constexpr size_t timestamp    = 9;
+		constexpr size_t accel        = 12;
+		constexpr size_t gyro         = 18;
+		constexpr size_t status       = 29;
+		constexpr size_t touchEvent   = 32;
+		constexpr size_t touchFrame   = 33;
+		constexpr size_t touch1       = 34;
+		constexpr size_t touch2       = 38;
+		// the previous touch packet, preceded by its own frame counter at 42
+		constexpr size_t lastTouch1   = 43;
+		constexpr size_t lastTouch2   = 47;
+
+		constexpr size_t size = lastTouch2 + 4;
+	}
+
+	static_assert(Ds4InputReportLayout::size <= Ds4Input::minimumReportSize);
+
+	/**
+	 * \brief The bits of the input data occupied by a field.
+	 */
+	struct FieldBits
+	{
+		Ds4InputFields_t field;
+		size_t offset;
+		size_t count;
+	};
+
+	constexpr std::array fieldBits {
+		FieldBits { Ds4InputFields::leftStickX,      Ds4InputReportLayout::leftStick * 8,          8 },
+		FieldBits { Ds4InputFields::leftStickY,      Ds4InputReportLayout::leftStick * 8 + 8,      8 },
+		FieldBits { Ds4InputFields::rightStickX,     Ds4InputReportLayout::rightStick * 8,         8 },
+		FieldBits { Ds4InputFields::rightStickY,     Ds4InputReportLayout::rightStick * 8 + 8,     8 },
+		FieldBits { Ds4InputFields::buttons,         Ds4InputReportLayout::buttons * 8,            18 },
+		FieldBits { Ds4InputFields::frameCount,      Ds4InputReportLayout::frameCount * 8 + 2,     6 },
+		FieldBits { Ds4InputFields::leftTrigger,     Ds4InputReportLayout::leftTrigger * 8,        8 },
+		FieldBits { Ds4InputFields::rightTrigger,    Ds4InputReportLayout::rightTrigger * 8,       8 },
+		FieldBits { Ds4InputFields::timestamp,       Ds4InputReportLayout::timestamp * 8,          16 },
+		FieldBits { Ds4InputFields::accelX,          Ds4InputReportLayout::accel * 8,              16 },
+		FieldBits { Ds4InputFields::accelY,          Ds4InputReportLayout::accel * 8 + 16,         16 },
+		FieldBits { Ds4InputFields::accelZ,          Ds4InputReportLayout::accel * 8 + 32,         16 },
+		FieldBits { Ds4InputFields::gyroX,           Ds4InputReportLayout::gyro * 8,               16 },
+		FieldBits { Ds4InputFields::gyroY,           Ds4InputReportLayout::gyro * 8 + 16,          16 },
+		FieldBits { Ds4InputFields::gyroZ,           Ds4InputReportLayout::gyro * 8 + 32,          16 },
+		FieldBits { Ds4InputFields::battery,         Ds4InputReportLayout::status * 8,             4 },
+		FieldBits { Ds4InputFields::extensions,      Ds4InputReportLayout::status * 8 + 4,         4 },
+		FieldBits { Ds4InputFields::touchEvent,      Ds4InputReportLayout::touchEvent * 8,         6 },
+		FieldBits { Ds4InputFields::touchFrame,      Ds4InputReportLayout::touchFrame * 8,         6 },
+		FieldBits { Ds4InputFields::touch1,          Ds4InputReportLayout::touch1 * 8,             8 },
+		FieldBits { Ds4InputFields::touchPoint1,     Ds4InputReportLayout::touch1 * 8 + 8,         24 },
+		FieldBits { Ds4InputFields::touch2,          Ds4InputReportLayout::touch2 * 8,             8 },
+		FieldBits { Ds4InputFields::touchPoint2,     Ds4InputReportLayout::touch2 * 8 + 8,         24 },
+		FieldBits { Ds4InputFields::lastTouchPoint1, Ds4InputReportLayout::lastTouch1 * 8 + 8,     24 },
+		FieldBits { Ds4InputFields::lastTouchPoint2, Ds4InputReportLayout::lastTouch2 * 8 + 8,     24 }
+	};
+
+	/**
+	 * \brief A field's bits within one 64-bit word of the input data.
+	 */
+	struct FieldMask
+	{
+		Ds4InputFields_t field;
+		size_t word;
+		uint64_t mask;
+	};
+
+	constexpr uint64_t bitRange(size_t first, size_t last)
+	{
+		// [first, last)
+		const uint64_t upper = last >= 64 ? ~0ull : (1ull << last) - 1;
+		return upper & ~((1ull << first) - 1);
+	}
+
+	/**
+	 * \brief \c fieldBits split at word boundaries. No field spans more than two words.
+	 */
+	constexpr auto fieldMasks = []
+	{
+		std::array<FieldMask, fieldBits.size() * 2> result {};
+
+		for (size_t i = 0; i < fieldBits.size(); ++i)
+		{
+			const FieldBits& bits = fieldBits[i];
+
+			const size_t first = bits.offset;
+			const size_t last  = bits.offset + bits.count;
+			const size_t word  = first / 64;
+			const size_t split = std::min(last, (word + 1) * 64);
+
+			result[i * 2] = { bits.field, word, bitRange(first - word * 64, split - word * 64) };
+
+			if (split < last)
+			{
+				result[i * 2 + 1] = { bits.field, word + 1, bitRange(0, last - split) };
+			}
+		}
+
+		return result;
+	}();
+
+	/**
+	 * \brief Normalized stick axis values indexed by raw value, in the range -1 to 1.
+	 * 128 is center; 0 and 1 both map to -1 so that the range is symmetrical.
+	 */
+	constexpr auto stickValues = []
+	{
+		std::array<float, 256> result {};
+
+		for (int i = 0; i < 256; ++i)
+		{
+			result[i] = static_cast<float>(std::clamp(i - 128, -127, 127)) / 127.0f;
+		}
+
+		return result;
+	}();
+
+	/**
+	 * \brief Normalized trigger axis values indexed by raw value, in the range 0 to 1.
+	 */
+	constexpr auto triggerValues = []
+	{
+		std::array<float, 256> result {};
+
+		for (int i = 0; i < 256; ++i)
+		{
+			result[i] = static_cast<float>(i) / 255.0f;
+		}
+
+		return result;
+	}();
+
+	/**
+	 * \brief Scale applied to raw accelerometer and gyroscope values.
+	 */
+	constexpr float motionScale = 1.0f / (std::numeric_limits<short>::max() + 1.0f);
+
+	static_assert(static_cast<Ds4Axes_t>(Ds4InputFields::leftStickX) == Ds4Axes::leftStickX &&
+	              static_cast<Ds4Axes_t>(Ds4InputFields::gyroZ) == Ds4Axes::gyroZ &&
+	              Ds4InputFields::axes == (Ds4Axes::leftStick | Ds4Axes::rightStick | Ds4Axes::leftTrigger | Ds4Axes::rightTrigger | Ds4Axes::accelerometer | Ds4Axes::gyroscope));
+
+	/**
+	 * \brief Loads a little-endian value from a potentially unaligned address.
+	 */
+	template <typename T>
+	T load(const uint8_t* p)
+	{
+		T result;
+		std::memcpy(&result, p, sizeof(T));
+		return result;
+	}
+
+	Ds4Vector3 loadVector3(const uint8_t* p)
+	{
+		return { load<int16_t>(p), load<int16_t>(p + 2), load<int16_t>(p + 4) };
+	}
+
+	/**
+	 * \brief Loads a touch point: one byte of inactive flag and ID,
+	 * followed by two 12-bit coordinates packed into three bytes.
+	 */
+	void loadTouch(const uint8_t* p, bool& active, uint8_t& id, Ds4Vector2& point)
+	{
+		active  = !(p[0] & 0x80);
+		id      = static_cast<uint8_t>(p[0] & 0x7F);
+		point.x = static_cast<short>(p[1] | ((p[2] & 0x0F) << 8));
+		point.y = static_cast<short>((p[2] >> 4) | (p[3] << 4));
+	}
+}
+
 inline void Ds4Input::addButton(bool pressed, Ds4Buttons_t buttons)
 {
 	if (pressed)
@@ -37,126 +226,152 @@ void Ds4Input::updateButtons()
 	}
 }
 
-void Ds4Input::updateAxes(const Ds4InputData& last)
+void Ds4Input::updateChangedFields(std::span<const uint8_t> buffer)
 {
-	axes = 0;
+	std::array<uint64_t, reportWords> report {};
+	std::memcpy(report.data(), buffer.data(), minimumReportSize);
 
-	if (data.leftStick.x != last.leftStick.x)
-	{
-		axes |= Ds4Axes::leftStickX;
-	}
+	std::array<uint64_t, reportWords> difference {};
 
-	if (data.leftStick.y != last.leftStick.y)
+	for (size_t i = 0; i < reportWords; ++i)
 	{
-		axes |= Ds4Axes::leftStickY;
+		difference[i] = report[i] ^ lastReport[i];
 	}
 
-	if (data.rightStick.x != last.rightStick.x)
-	{
-		axes |= Ds4Axes::rightStickX;
-	}
+	lastReport = report;
 
-	if (data.rightStick.y != last.rightStick.y)
-	{
-		axes |= Ds4Axes::rightStickY;
-	}
+	changedFields = 0;
 
-	if (data.leftTrigger != last.leftTrigger)
+	for (const FieldMask& field : fieldMasks)
 	{
-		axes |= Ds4Axes::leftTrigger;
+		if (difference[field.word] & field.mask)
+		{
+			changedFields |= field.field;
+		}
 	}
+}
 
-	if (data.rightTrigger != last.rightTrigger)
+void Ds4Input::decode(std::span<const uint8_t> buffer, Ds4InputData& out)
+{
+	namespace layout = Ds4InputReportLayout;
+
+	const uint8_t* p = buffer.data();
+
+	out.leftStick.x   = p[layout::leftStick];
+	out.leftStick.y   = p[layout::leftStick + 1];
+	out.rightStick.x  = p[layout::rightStick];
+	out.rightStick.y  = p[layout::rightStick + 1];
+	out.activeButtons = load<Ds4ButtonsRaw_t>(p + layout::buttons);
+	out.frameCount    = decodeFrameCount(buffer);
+	out.leftTrigger   = p[layout::leftTrigger];
+	out.rightTrigger  = p[layout::rightTrigger];
+	out.timestamp     = decodeTimestamp(buffer);
+	out.accel         = loadVector3(p + layout::accel);
+	out.gyro          = loadVector3(p + layout::gyro);
+	out.extensions    = static_cast<uint8_t>(p[layout::status] >> 4);
+	out.touchEvent    = static_cast<uint8_t>(p[layout::touchEvent] & 0x3F);
+	out.touchFrame    = static_cast<uint8_t>(p[layout::touchFrame] & 0x3F);
+
+	loadTouch(p + layout::touch1, out.touch1, out.touch1Id, out.touchPoint1);
+	loadTouch(p + layout::touch2, out.touch2, out.touch2Id, out.touchPoint2);
+
+	bool active;
+	uint8_t id;
+	loadTouch(p + layout::lastTouch1, active, id, out.lastTouchPoint1);
+	loadTouch(p + layout::lastTouch2, active, id, out.lastTouchPoint2);
+
+	// normalized to the range 1-10 (see Ds4Device::battery)
+	uint8_t battery = p[layout::status] & 0x0F;
+
+	if (!(out.extensions & Ds4Extensions::cable))
 	{
-		axes |= Ds4Axes::rightTrigger;
+		++battery;
 	}
 
-	if (data.accel.x != last.accel.x)
-	{
-		axes |= Ds4Axes::accelX;
-	}
-	
-	if (data.accel.y != last.accel.y)
-	{
-		axes |= Ds4Axes::accelY;
-	}
-	
-	if (data.accel.z != last.accel.z)
-	{
-		axes |= Ds4Axes::accelZ;
-	}
-	
-	if (data.gyro.x != last.gyro.x)
-	{
-		axes |= Ds4Axes::gyroX;
-	}
-	
-	if (data.gyro.y != last.gyro.y)
-	{
-		axes |= Ds4Axes::gyroY;
-	}
-	
-	if (data.gyro.z != last.gyro.z)
-	{
-		axes |= Ds4Axes::gyroZ;
-	}
+	out.battery = std::min<uint8_t>(battery, 10);
 }
 
-void Ds4Input::update(std::span<const uint8_t> buffer)
+uint8_t Ds4Input::decodeFrameCount(std::span<const uint8_t> buffer)
 {
-	Ds4InputData last = data;
+	return static_cast<uint8_t>((buffer[Ds4InputReportLayout::frameCount] >> 2) & 0x3F);
+}
 
-	data.leftStick.x       = buffer[0];
-	data.leftStick.y       = buffer[1];
-	data.rightStick.x      = buffer[2];
-	data.rightStick.y      = buffer[3];
-	data.frameCount        = static_cast<uint8_t>((buffer[6] >> 2) & 0x3F);
-	data.leftTrigger       = buffer[7];
-	data.rightTrigger      = buffer[8];
-	data.accel.x           = *reinterpret_cast<const int16_t*>(&buffer[12]);
-	data.accel.y           = *reinterpret_cast<const int16_t*>(&buffer[14]);
-	data.accel.z           = *reinterpret_cast<const int16_t*>(&buffer[16]);
-	data.gyro.x            = *reinterpret_cast<const int16_t*>(&buffer[18]);
-	data.gyro.y            = *reinterpret_cast<const int16_t*>(&buffer[20]);
-	data.gyro.z            = *reinterpret_cast<const int16_t*>(&buffer[22]);
-	data.extensions        = static_cast<uint8_t>(buffer[29] >> 4);
-	data.battery           = static_cast<uint8_t>(buffer[29] & 0x0F);
-	data.touchEvent        = static_cast<uint8_t>(buffer[32] & 0x3F);
-	data.touchFrame        = static_cast<uint8_t>(buffer[33] & 0x3F);
-	data.touch1            = !(buffer[34] & 0x80);
-	data.touch1Id          = static_cast<uint8_t>(buffer[34] & 0x7F);
-	data.touchPoint1.x     = static_cast<short>(*reinterpret_cast<const int16_t*>(&buffer[35]) & 0xFFF);
-	data.touchPoint1.y     = static_cast<short>((*reinterpret_cast<const int16_t*>(&buffer[36]) >> 4) & 0xFFF);
-	data.touch2            = !(buffer[38] & 0x80);
-	data.touch2Id          = static_cast<uint8_t>(buffer[38] & 0x7F);
-	data.touchPoint2.x     = static_cast<short>(*reinterpret_cast<const int16_t*>(&buffer[39]) & 0xFFF);
-	data.touchPoint2.y     = static_cast<short>((*reinterpret_cast<const int16_t*>(&buffer[40]) >> 4) & 0xFFF);
-	data.lastTouchPoint1.x = static_cast<short>(*reinterpret_cast<const int16_t*>(&buffer[43]) & 0xFFF);
-	data.lastTouchPoint1.y = static_cast<short>((*reinterpret_cast<const int16_t*>(&buffer[44]) >> 4) & 0xFFF);
-	data.lastTouchPoint2.x = static_cast<short>(*reinterpret_cast<const int16_t*>(&buffer[47]) & 0xFFF);
-	data.lastTouchPoint2.y = static_cast<short>((*reinterpret_cast<const int16_t*>(&buffer[48]) >> 4) & 0xFFF);
+uint16_t Ds4Input::decodeTimestamp(std::span<const uint8_t> buffer)
+{
+	return load<uint16_t>(&buffer[Ds4InputReportLayout::timestamp]);
+}
 
-	updateAxes(last);
+void Ds4Input::decodeBatch(std::span<const std::span<const uint8_t>> reports, std::span<Ds4InputData> out)
+{
+	const size_t count = std::min(reports.size(), out.size());
 
-	if (!(data.extensions & Ds4Extensions::cable))
+	for (size_t i = 0; i < count; ++i)
 	{
-		++data.battery;
+		decode(reports[i], out[i]);
 	}
+}
 
-	if (data.battery > 10)
+void Ds4Input::updateAxisValues()
+{
+	axisValues[axisIndex(Ds4Axes::leftStickX)]   =  stickValues[data.leftStick.x];
+	axisValues[axisIndex(Ds4Axes::leftStickY)]   = -stickValues[data.leftStick.y];
+	axisValues[axisIndex(Ds4Axes::rightStickX)]  =  stickValues[data.rightStick.x];
+	axisValues[axisIndex(Ds4Axes::rightStickY)]  = -stickValues[data.rightStick.y];
+	axisValues[axisIndex(Ds4Axes::leftTrigger)]  =  triggerValues[data.leftTrigger];
+	axisValues[axisIndex(Ds4Axes::rightTrigger)] =  triggerValues[data.rightTrigger];
+
+	const std::array<short, 6> motion {
+		data.accel.x, data.accel.y, data.accel.z,
+		data.gyro.x, data.gyro.y, data.gyro.z
+	};
+
+	// Kept as a simple loop over contiguous data so that it vectorizes.
+	float* out = &axisValues[axisIndex(Ds4Axes::accelX)];
+
+	for (size_t i = 0; i < motion.size(); ++i)
 	{
-		data.battery = 10;
+		out[i] = std::clamp(static_cast<float>(motion[i]) * motionScale, 0.0f, 1.0f);
 	}
+}
 
-	data.activeButtons = *reinterpret_cast<const Ds4ButtonsRaw_t*>(&buffer[4]);
+void Ds4Input::updateDeviceTime()
+{
+	if (!hasTimestamp)
+	{
+		hasTimestamp     = true;
+		lastTimestamp    = data.timestamp;
+		deviceDeltaTime_ = DeviceDuration::zero();
+		return;
+	}
 
-	updateButtons();
+	// Unsigned subtraction accounts for the timestamp wrapping.
+	deviceDeltaTime_ = DeviceDuration(static_cast<uint16_t>(data.timestamp - lastTimestamp));
+	deviceTime_ += deviceDeltaTime_;
+	lastTimestamp = data.timestamp;
+}
+
+void Ds4Input::update(std::span<const uint8_t> buffer)
+{
+	updateChangedFields(buffer);
 
-	updateChangedState();
+	decode(buffer, data);
+	updateAxisValues();
+	updateDeviceTime();
+
+	updateButtons();
+	updateChangedState(changedFields);
 }
 
 void Ds4Input::updateChangedState()
 {
+	updateChangedState(0);
+}
+
+void Ds4Input::updateChangedState(Ds4InputFields_t changed)
+{
+	changedFields = changed;
+	axes = static_cast<Ds4Axes_t>(changed & Ds4InputFields::axes);
+
 	releasedButtons = lastHeldButtons & (heldButtons ^ lastHeldButtons);
 	pressedButtons  = heldButtons & (heldButtons ^ lastHeldButtons);
 	lastHeldButtons = heldButtons;
@@ -164,77 +379,52 @@ void Ds4Input::updateChangedState()
 
 	constexpr Ds4Buttons_t touchMask = Ds4Buttons::touch1 | Ds4Buttons::touch2 | Ds4Buttons::touchButton;
 
-	touchChanged = lastTouchFrame != data.touchFrame ||
+	touchChanged = (changed & Ds4InputFields::touchFrame) != 0 ||
 	               (pressedButtons & touchMask) != 0 ||
 	               (releasedButtons & touchMask) != 0;
-
-	lastTouchFrame = data.touchFrame;
 }
 
-float Ds4Input::getAxis(Ds4Axes_t axis, const std::optional<AxisPolarity>& polarity) const
+Ds4Input::DeviceDuration Ds4Input::deviceTime() const
 {
-	float result;
-
-	switch (axis)
-	{
-		case Ds4Axes::leftStickX:
-			result = std::min(1.0f, std::clamp(data.leftStick.x - 128, -127, 127) / 127.0f);
-			result = std::clamp(result, -1.0f, 1.0f);
-			break;
-		case Ds4Axes::leftStickY:
-			result = -std::min(1.0f, std::clamp(data.leftStick.y - 128, -127, 127) / 127.0f);
-			result = std::clamp(result, -1.0f, 1.0f);
-			break;
-
-		case Ds4Axes::rightStickX:
-			result = std::min(1.0f, std::clamp(data.rightStick.x - 128, -127, 127) / 127.0f);
-			result = std::clamp(result, -1.0f, 1.0f);
-			break;
-		case Ds4Axes::rightStickY:
-			result = -std::min(1.0f, std::clamp(data.rightStick.y - 128, -127, 127) / 127.0f);
-			result = std::clamp(result, -1.0f, 1.0f);
-			break;
+	return deviceTime_;
+}
 
-		case Ds4Axes::leftTrigger:
-			result = static_cast<float>(data.leftTrigger) / 255.0f;
-			break;
-		case Ds4Axes::rightTrigger:
-			result = static_cast<float>(data.rightTrigger) / 255.0f;
-			break;
+Ds4Input::DeviceDuration Ds4Input::deviceDeltaTime() const
+{
+	return deviceDeltaTime_;
+}
 
-		case Ds4Axes::accelX:
-			result = std::clamp(static_cast<float>(data.accel.x) / (std::numeric_limits<short>::max() + 1.0f), 0.0f, 1.0f);
-			break;
-		case Ds4Axes::accelY:
-			result = std::clamp(static_cast<float>(data.accel.y) / (std::numeric_limits<short>::max() + 1.0f), 0.0f, 1.0f);
-			break;
-		case Ds4Axes::accelZ:
-			result = std::clamp(static_cast<float>(data.accel.z) / (std::numeric_limits<short>::max() + 1.0f), 0.0f, 1.0f);
-			break;
+float Ds4Input::getAxis(Ds4Axes_t axis, const std::optional<AxisPolarity>& polarity) const
+{
+	return applyPolarity(axisValues[axisIndex(axis)], polarity);
+}
 
-		case Ds4Axes::gyroX:
-			result = std::clamp(static_cast<float>(data.gyro.x) / (std::numeric_limits<short>::max() + 1.0f), 0.0f, 1.0f);
-			break;
-		case Ds4Axes::gyroY:
-			result = std::clamp(static_cast<float>(data.gyro.y) / (std::numeric_limits<short>::max() + 1.0f), 0.0f, 1.0f);
-			break;
-		case Ds4Axes::gyroZ:
-			result = std::clamp(static_cast<float>(data.gyro.z) / (std::numeric_limits<short>::max() + 1.0f), 0.0f, 1.0f);
-			break;
+const std::array<float, Ds4Input::axisCount>& Ds4Input::getAllAxes() const
+{
+	return axisValues;
+}
 
-		default:
-			throw std::out_of_range("invalid Ds4Axes");
+size_t Ds4Input::axisIndex(Ds4Axes_t axis)
+{
+	if (!std::has_single_bit(axis) || axis >= (1u << axisCount))
+	{
+		throw std::out_of_range("invalid Ds4Axes");
 	}
 
+	return static_cast<size_t>(std::countr_zero(axis));
+}
+
+float Ds4Input::applyPolarity(float value, const std::optional<AxisPolarity>& polarity)
+{
 	if (!polarity)
 	{
-		return result;
+		return value;
 	}
 
 	if (*polarity == +AxisPolarity::negative)
 	{
-		result = -result;
+		value = -value;
 	}
 
-	return std::max(0.0f, result);
+	return std::max(0.0f, value);
 }
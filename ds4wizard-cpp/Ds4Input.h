@@ -1,10 +1,56 @@
 #pragma once
 
+#include <array>
+#include <chrono>
 #include <optional>
 #include <span>
 
 #include "Ds4InputData.h"
 
+using Ds4InputFields_t = uint64_t;
+
+/**
+ * \brief Bitfield identifying the fields of an input report.
+ * The axis bits are identical to their \c Ds4Axes counterparts.
+ * \sa Ds4Input::changedFields
+ */
+struct Ds4InputFields
+{
+	enum T : Ds4InputFields_t
+	{
+		leftStickX      = 1ull << 0,
+		leftStickY      = 1ull << 1,
+		rightStickX     = 1ull << 2,
+		rightStickY     = 1ull << 3,
+		leftTrigger     = 1ull << 4,
+		rightTrigger    = 1ull << 5,
+		accelX          = 1ull << 6,
+		accelY          = 1ull << 7,
+		accelZ          = 1ull << 8,
+		gyroX           = 1ull << 9,
+		gyroY           = 1ull << 10,
+		gyroZ           = 1ull << 11,
+		buttons         = 1ull << 12,
+		frameCount      = 1ull << 13,
+		battery         = 1ull << 14,
+		extensions      = 1ull << 15,
+		touchEvent      = 1ull << 16,
+		touchFrame      = 1ull << 17,
+		touch1          = 1ull << 18,
+		touchPoint1     = 1ull << 19,
+		touch2          = 1ull << 20,
+		touchPoint2     = 1ull << 21,
+		lastTouchPoint1 = 1ull << 22,
+		lastTouchPoint2 = 1ull << 23,
+		timestamp       = 1ull << 24
+	};
+
+	static constexpr Ds4InputFields_t leftStick  = leftStickX | leftStickY;
+	static constexpr Ds4InputFields_t rightStick = rightStickX | rightStickY;
+	static constexpr Ds4InputFields_t axes       = 0xFFF;
+	static constexpr Ds4InputFields_t touch      = touchEvent | touchFrame | touch1 | touchPoint1 | touch2 | touchPoint2;
+};
+
 /**
  * \brief Serialized input report from a \c Ds4Device
  * \sa Ds4Device
@@ -12,6 +58,21 @@
 class Ds4Input
 {
 public:
+	/**
+	 * \brief The minimum number of bytes of input data \c update and \c decode will read.
+	 */
+	static constexpr size_t minimumReportSize = 51;
+
+	/**
+	 * \brief The number of axes provided by the DualShock 4. \sa Ds4Axes
+	 */
+	static constexpr size_t axisCount = 12;
+
+	/**
+	 * \brief A duration measured by the device's clock, which ticks every 5 1/3 microseconds.
+	 */
+	using DeviceDuration = std::chrono::duration<int64_t, std::ratio<16, 3'000'000>>;
+
 	Ds4Input() = default;
 	
 	/**
@@ -48,6 +109,13 @@ public:
 	 */
 	Ds4Axes_t axes = 0; // TODO: private set
 
+	/**
+	 * \brief Each field of the input report that has changed since the last poll.
+	 * Consumers can use this to skip work for unchanged fields.
+	 * \sa Ds4InputFields, Ds4InputFields_t
+	 */
+	Ds4InputFields_t changedFields = 0; // TODO: private set
+
 	Ds4InputData data {};
 
 	/**
@@ -57,10 +125,52 @@ public:
 	void update(std::span<const uint8_t> buffer);
 
 	/**
-	 * \brief Updates button change states since last poll.
+	 * \brief Decodes raw input report data without tracking any changes.
+	 * \param buffer Buffer containing at least \c minimumReportSize bytes of raw input report data.
+	 * \param out The structure to decode into.
+	 */
+	static void decode(std::span<const uint8_t> buffer, Ds4InputData& out);
+
+	/**
+	 * \brief Decodes only the frame counter of raw input report data.
+	 * \param buffer Buffer containing at least \c minimumReportSize bytes of raw input report data.
+	 * \sa Ds4InputData::frameCount
+	 */
+	static uint8_t decodeFrameCount(std::span<const uint8_t> buffer);
+
+	/**
+	 * \brief Decodes only the device timestamp of raw input report data.
+	 * \param buffer Buffer containing at least \c minimumReportSize bytes of raw input report data.
+	 * \sa Ds4InputData::timestamp
+	 */
+	static uint16_t decodeTimestamp(std::span<const uint8_t> buffer);
+
+	/**
+	 * \brief Decodes many input reports at once, e.g. from a capture.
+	 * \param reports Buffers containing raw input report data. \sa decode
+	 * \param out The structures to decode into. Only as many reports as fit are decoded.
+	 */
+	static void decodeBatch(std::span<const std::span<const uint8_t>> reports, std::span<Ds4InputData> out);
+
+	/**
+	 * \brief Updates button change states since last poll when no new report was received.
 	 */
 	void updateChangedState();
 
+	/**
+	 * \brief Gets the time of the last report according to the device's clock, unwrapped
+	 * from \c Ds4InputData::timestamp. The first report received is at time zero.
+	 * Gaps between reports longer than the timestamp's wrap period are undercounted.
+	 */
+	[[nodiscard]] DeviceDuration deviceTime() const;
+
+	/**
+	 * \brief Gets the time between the last two reports according to the device's clock.
+	 * Unlike host time, this is unaffected by transport delay, making it suitable for
+	 * integrating motion sensor data.
+	 */
+	[[nodiscard]] DeviceDuration deviceDeltaTime() const;
+
 	/**
 	 * \brief Get the magnitude of an axis.
 	 * \param axis The axis to retrieve.
@@ -69,11 +179,51 @@ public:
 	 */
 	[[nodiscard]] float getAxis(Ds4Axes_t axis, const std::optional<AxisPolarity>& polarity) const;
 
+	/**
+	 * \brief Gets the normalized value of every axis as of the last report, indexed by \c axisIndex.
+	 * Sticks are in the range -1 to 1; all other axes are in the range 0 to 1.
+	 */
+	[[nodiscard]] const std::array<float, axisCount>& getAllAxes() const;
+
+	/**
+	 * \brief Gets the index of an axis within \c getAllAxes.
+	 * \param axis A single \c Ds4Axes bit.
+	 * \throws std::out_of_range if \p axis is not exactly one axis.
+	 */
+	static size_t axisIndex(Ds4Axes_t axis);
+
+	/**
+	 * \brief Applies a desired polarity to a normalized axis value.
+	 * \param value The normalized axis value.
+	 * \param polarity The desired polarity of the axis, or \c std::nullopt for both positive and negative.
+	 * \return \p value, or \c 0.0f if it does not align with the desired \a polarity.
+	 */
+	static float applyPolarity(float value, const std::optional<AxisPolarity>& polarity);
+
 private:
+	static constexpr size_t reportWords = (minimumReportSize + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+	/**
+	 * \brief The raw input data of the last report, zero-padded to a whole number of words.
+	 */
+	std::array<uint64_t, reportWords> lastReport {};
+
+	/**
+	 * \brief Normalized axis values as of the last report. \sa getAllAxes
+	 */
+	std::array<float, axisCount> axisValues {};
+
 	Ds4Buttons_t lastHeldButtons = 0;
-	uint8_t lastTouchFrame {};
+
+	bool hasTimestamp = false;
+	uint16_t lastTimestamp = 0;
+	DeviceDuration deviceTime_ {};
+	DeviceDuration deviceDeltaTime_ {};
 
 	void addButton(bool pressed, Ds4Buttons_t buttons);
 	void updateButtons();
-	void updateAxes(const Ds4InputData& last);
+	void updateChangedFields(std::span<const uint8_t> buffer);
+	void updateAxisValues();
+	void updateDeviceTime();
+	void updateChangedState(Ds4InputFields_t changed);
 };
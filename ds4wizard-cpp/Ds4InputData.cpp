@@ -153,6 +153,7 @@ bool Ds4InputData::operator==(const Ds4InputData& other) const
 	       rightStick      == other.rightStick &&
 	       leftTrigger     == other.leftTrigger &&
 	       rightTrigger    == other.rightTrigger &&
+	       timestamp       == other.timestamp &&
 	       battery         == other.battery &&
 	       accel           == other.accel &&
 	       gyro            == other.gyro &&
@@ -93,6 +93,13 @@ struct Ds4InputData
 	uint8_t    frameCount;
 	uint8_t    leftTrigger;
 	uint8_t    rightTrigger;
+
+	/**
+	 * \brief The device's free-running clock at the time the report was generated, in
+	 * units of \c Ds4Input::DeviceDuration. Wraps roughly every 350 milliseconds.
+	 */
+	uint16_t   timestamp;
+
 	uint8_t    battery;
 	Ds4Vector3 accel;
 	Ds4Vector3 gyro;
@@ -0,0 +1,153 @@
+#include "pch.h"
+
+#include <algorithm>
+
+#include "Ds4ReportStatistics.h"
+
+using namespace std::chrono;
+
+void Ds4ReportStatistics::push(uint8_t frameCount, uint16_t timestamp, Stopwatch::TimePoint time)
+{
+	++received_;
+
+	if (hasLast)
+	{
+		// Unsigned subtraction accounts for the timestamp wrapping.
+		deviceTime += Ds4Input::DeviceDuration(static_cast<uint16_t>(timestamp - lastTimestamp));
+	}
+
+	lastTimestamp = timestamp;
+
+	const Stopwatch::Duration offset = time.time_since_epoch() - duration_cast<Stopwatch::Duration>(deviceTime);
+
+	if (!hasLast)
+	{
+		hasLast         = true;
+		lastFrameCount  = frameCount;
+		lastTime        = time;
+		windowStart     = time;
+		minOffset       = offset;
+		windowMinOffset = offset;
+		return;
+	}
+
+	minOffset       = std::min(minOffset, offset);
+	windowMinOffset = std::min(windowMinOffset, offset);
+
+	const Stopwatch::Duration delay = offset - minOffset;
+	const Stopwatch::Duration delayChange = delay > transportDelay_ ? delay - transportDelay_ : transportDelay_ - delay;
+
+	transportJitter_ += (delayChange - transportJitter_) / 16;
+	transportDelay_ = delay;
+	peakTransportDelay_ = std::max(peakTransportDelay_, delay);
+
+	// The frame counter is 6 bits wide and increments once per report.
+	const auto gap = static_cast<uint8_t>((frameCount - lastFrameCount) & 0x3F);
+
+	if (gap > 1)
+	{
+		lost_ += gap - 1;
+	}
+
+	++windowCount;
+
+	const Stopwatch::Duration interval = time - lastTime;
+
+	lastFrameCount = frameCount;
+	lastTime       = time;
+
+	if (meanInterval_ == Stopwatch::Duration::zero())
+	{
+		meanInterval_ = interval;
+	}
+	else
+	{
+		// exponential moving average with a weight of 1/16
+		meanInterval_ += (interval - meanInterval_) / 16;
+	}
+
+	const Stopwatch::Duration deviation = interval > meanInterval_ ? interval - meanInterval_ : meanInterval_ - interval;
+
+	peakJitter_ = std::max(peakJitter_, deviation);
+
+	const auto bucket = static_cast<size_t>(deviation / jitterBucketWidth);
+	++jitter_[std::min(bucket, jitter_.size() - 1)];
+
+	const Stopwatch::Duration windowElapsed = time - windowStart;
+
+	if (windowElapsed >= rateWindow)
+	{
+		reportRate_ = static_cast<float>(windowCount) / duration<float>(windowElapsed).count();
+		windowCount = 0;
+		windowStart = time;
+
+		minOffset       = windowMinOffset;
+		windowMinOffset = offset;
+	}
+}
+
+void Ds4ReportStatistics::reset()
+{
+	*this = Ds4ReportStatistics();
+}
+
+std::optional<Stopwatch::TimePoint> Ds4ReportStatistics::lastReportTime() const
+{
+	if (!hasLast)
+	{
+		return std::nullopt;
+	}
+
+	return lastTime;
+}
+
+uint64_t Ds4ReportStatistics::received() const
+{
+	return received_;
+}
+
+uint64_t Ds4ReportStatistics::lost() const
+{
+	return lost_;
+}
+
+float Ds4ReportStatistics::lossRatio() const
+{
+	const uint64_t expected = received_ + lost_;
+	return expected > 0 ? static_cast<float>(lost_) / static_cast<float>(expected) : 0.0f;
+}
+
+float Ds4ReportStatistics::reportRate() const
+{
+	return reportRate_;
+}
+
+Stopwatch::Duration Ds4ReportStatistics::meanInterval() const
+{
+	return meanInterval_;
+}
+
+Stopwatch::Duration Ds4ReportStatistics::peakJitter() const
+{
+	return peakJitter_;
+}
+
+Stopwatch::Duration Ds4ReportStatistics::transportDelay() const
+{
+	return transportDelay_;
+}
+
+Stopwatch::Duration Ds4ReportStatistics::peakTransportDelay() const
+{
+	return peakTransportDelay_;
+}
+
+Stopwatch::Duration Ds4ReportStatistics::transportJitter() const
+{
+	return transportJitter_;
+}
+
+const Ds4ReportStatistics::JitterHistogram& Ds4ReportStatistics::jitter() const
+{
+	return jitter_;
+}
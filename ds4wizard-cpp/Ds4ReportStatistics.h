@@ -0,0 +1,139 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+
+#include "Ds4Input.h"
+#include "Stopwatch.h"
+
+/**
+ * \brief Tracks lost reports, report rate, inter-arrival jitter and transport delay of a
+ * single connection using the frame counter and timestamp embedded in every input report.
+ */
+class Ds4ReportStatistics
+{
+public:
+	/**
+	 * \brief Width of each bucket of the jitter histogram.
+	 */
+	static constexpr std::chrono::microseconds jitterBucketWidth { 250 };
+
+	/**
+	 * \brief Number of buckets in the jitter histogram. The last bucket also
+	 * counts every deviation larger than it.
+	 */
+	static constexpr size_t jitterBucketCount = 16;
+
+	using JitterHistogram = std::array<uint64_t, jitterBucketCount>;
+
+private:
+	static constexpr std::chrono::milliseconds rateWindow { 1000 };
+
+	bool hasLast = false;
+	uint8_t lastFrameCount = 0;
+	uint16_t lastTimestamp = 0;
+	Stopwatch::TimePoint lastTime {};
+
+	/**
+	 * \brief The device's clock as seen over this connection, unwrapped from report timestamps.
+	 */
+	Ds4Input::DeviceDuration deviceTime {};
+
+	uint64_t received_ = 0;
+	uint64_t lost_ = 0;
+
+	Stopwatch::TimePoint windowStart {};
+	uint64_t windowCount = 0;
+	float reportRate_ = 0.0f;
+
+	/**
+	 * \brief Host arrival time minus device time of the report that arrived soonest after being
+	 * generated, i.e. the baseline against which transport delay is measured.
+	 * This is re-established every \c rateWindow to follow drift between the two clocks.
+	 */
+	Stopwatch::Duration minOffset {};
+	Stopwatch::Duration windowMinOffset {};
+
+	Stopwatch::Duration transportDelay_ {};
+	Stopwatch::Duration peakTransportDelay_ {};
+	Stopwatch::Duration transportJitter_ {};
+
+	Stopwatch::Duration meanInterval_ {};
+	Stopwatch::Duration peakJitter_ {};
+	JitterHistogram jitter_ {};
+
+public:
+	/**
+	 * \brief Records the arrival of a report.
+	 * \param frameCount The frame counter of the report.
+	 * \param timestamp The device timestamp of the report.
+	 * \param time The time at which the report was received.
+	 */
+	void push(uint8_t frameCount, uint16_t timestamp, Stopwatch::TimePoint time);
+
+	/**
+	 * \brief Clears all statistics, e.g. when the connection is re-established.
+	 */
+	void reset();
+
+	/**
+	 * \brief The number of reports received.
+	 */
+	[[nodiscard]] uint64_t received() const;
+
+	/**
+	 * \brief The time at which the last report was received, if any.
+	 */
+	[[nodiscard]] std::optional<Stopwatch::TimePoint> lastReportTime() const;
+
+	/**
+	 * \brief The number of reports the frame counter indicates were skipped.
+	 * Gaps of 64 or more consecutive reports wrap the counter and are undercounted.
+	 */
+	[[nodiscard]] uint64_t lost() const;
+
+	/**
+	 * \brief The fraction of reports that were lost, in the range 0 to 1.
+	 */
+	[[nodiscard]] float lossRatio() const;
+
+	/**
+	 * \brief The number of reports received per second over the last complete one second window.
+	 */
+	[[nodiscard]] float reportRate() const;
+
+	/**
+	 * \brief The smoothed time between consecutive reports.
+	 */
+	[[nodiscard]] Stopwatch::Duration meanInterval() const;
+
+	/**
+	 * \brief The largest deviation of an inter-arrival time from \c meanInterval.
+	 */
+	[[nodiscard]] Stopwatch::Duration peakJitter() const;
+
+	/**
+	 * \brief The delay of the last report between being generated and being received, beyond the
+	 * smallest delay observed. The absolute delay cannot be known because the clocks are not synchronized.
+	 */
+	[[nodiscard]] Stopwatch::Duration transportDelay() const;
+
+	/**
+	 * \brief The largest \c transportDelay observed.
+	 */
+	[[nodiscard]] Stopwatch::Duration peakTransportDelay() const;
+
+	/**
+	 * \brief The smoothed variation in transport delay between consecutive reports,
+	 * computed as described by RFC 3550 section 6.4.1.
+	 */
+	[[nodiscard]] Stopwatch::Duration transportJitter() const;
+
+	/**
+	 * \brief Counts of deviations of inter-arrival times from \c meanInterval,
+	 * bucketed by \c jitterBucketWidth.
+	 */
+	[[nodiscard]] const JitterHistogram& jitter() const;
+};
@@ -0,0 +1,119 @@
+#include "pch.h"
+
+#include <cmath>
+
+#include "Ds4TouchGestures.h"
+
+void Ds4TouchGestures::update(const Ds4TouchHistory& history, Ds4Buttons_t held)
+{
+	if (history.empty())
+	{
+		return;
+	}
+
+	const Ds4TouchSample sample1 = history.get(Ds4Buttons::touch1, history.newest());
+	const Ds4TouchSample sample2 = history.get(Ds4Buttons::touch2, history.newest());
+
+	const double dt = hasSample
+		? std::chrono::duration<double>(Ds4TouchHistory::elapsed(last, sample1)).count()
+		: 0.0;
+
+	last      = sample1;
+	hasSample = true;
+
+	auto track = [&](Ds4Buttons_t sender, Ds4MotionFit<2>& fit, const Ds4Vector2& point)
+	{
+		if (!(held & sender))
+		{
+			// keep the fit as it was, so that a flick reads the velocity at release
+			return;
+		}
+
+		if (!(touching & sender))
+		{
+			fit.reset();
+		}
+
+		fit.add(dt, { static_cast<double>(point.x), static_cast<double>(point.y) });
+	};
+
+	track(Ds4Buttons::touch1, motion1, sample1.point);
+	track(Ds4Buttons::touch2, motion2, sample2.point);
+
+	constexpr Ds4Buttons_t both = Ds4Buttons::touch1 | Ds4Buttons::touch2;
+
+	if ((held & both) == both)
+	{
+		if ((touching & both) != both)
+		{
+			spread.reset();
+			midpoint.reset();
+		}
+
+		const double dx = sample2.point.x - sample1.point.x;
+		const double dy = sample2.point.y - sample1.point.y;
+
+		spread.add(dt, { std::sqrt(dx * dx + dy * dy) });
+
+		midpoint.add(dt, {
+			(sample1.point.x + sample2.point.x) / 2.0,
+			(sample1.point.y + sample2.point.y) / 2.0
+		});
+	}
+
+	touching = held & both;
+}
+
+bool Ds4TouchGestures::isTouching(Ds4Buttons_t sender) const
+{
+	return !!(touching & sender);
+}
+
+const Ds4TouchSample& Ds4TouchGestures::lastSample() const
+{
+	return last;
+}
+
+Vector2 Ds4TouchGestures::velocity(Ds4Buttons_t sender) const
+{
+	return toVector(motion(sender).velocity());
+}
+
+Vector2 Ds4TouchGestures::acceleration(Ds4Buttons_t sender) const
+{
+	return toVector(motion(sender).acceleration());
+}
+
+float Ds4TouchGestures::spreadVelocity() const
+{
+	constexpr Ds4Buttons_t both = Ds4Buttons::touch1 | Ds4Buttons::touch2;
+
+	if ((touching & both) != both)
+	{
+		return 0.0f;
+	}
+
+	return static_cast<float>(spread.velocity()[0]);
+}
+
+Vector2 Ds4TouchGestures::midpointVelocity() const
+{
+	constexpr Ds4Buttons_t both = Ds4Buttons::touch1 | Ds4Buttons::touch2;
+
+	if ((touching & both) != both)
+	{
+		return Vector2::zero;
+	}
+
+	return toVector(midpoint.velocity());
+}
+
+const Ds4MotionFit<2>& Ds4TouchGestures::motion(Ds4Buttons_t sender) const
+{
+	return (sender & Ds4Buttons::touch2) && !(sender & Ds4Buttons::touch1) ? motion2 : motion1;
+}
+
+Vector2 Ds4TouchGestures::toVector(const std::array<double, 2>& value)
+{
+	return { static_cast<float>(value[0]), static_cast<float>(value[1]) };
+}
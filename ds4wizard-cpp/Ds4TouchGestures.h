@@ -0,0 +1,238 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+
+#include "enums.h"
+#include "Ds4TouchHistory.h"
+#include "Vector2.h"
+
+/**
+ * \brief A running least-squares fit of a quadratic in time to an \p N dimensional signal, from which
+ * its velocity and acceleration at the newest sample are taken. Older samples are weighted down
+ * exponentially, and every sum is kept relative to the newest sample, so adding a sample is O(1)
+ * and never revisits old ones.
+ * \tparam N The number of dimensions of the signal.
+ */
+template <size_t N>
+class Ds4MotionFit
+{
+	/**
+	 * \brief Sums of w * u^k for k = 0..4, where u is the age of a sample in seconds (zero or negative).
+	 */
+	std::array<double, 5> timeSums {};
+
+	/**
+	 * \brief Sums of w * u^k * x for k = 0..2, per dimension.
+	 */
+	std::array<std::array<double, 3>, N> valueSums {};
+
+public:
+	/**
+	 * \brief How quickly old samples lose weight: a sample this old has 1/e of the weight of a new one.
+	 */
+	static constexpr double timeConstant = 0.05;
+
+	/**
+	 * \brief Discards every sample.
+	 */
+	void reset()
+	{
+		timeSums  = {};
+		valueSums = {};
+	}
+
+	/**
+	 * \brief Adds a sample taken \p dt seconds after the previous one.
+	 */
+	void add(double dt, const std::array<double, N>& value)
+	{
+		const double decay = std::exp(-dt / timeConstant);
+
+		const double d1 = dt;
+		const double d2 = d1 * dt;
+		const double d3 = d2 * dt;
+		const double d4 = d3 * dt;
+
+		// every existing sample becomes dt older: expand (u - dt)^k in terms of the existing sums
+		const std::array<double, 5> t = timeSums;
+
+		timeSums = {
+			t[0],
+			t[1] - d1 * t[0],
+			t[2] - 2.0 * d1 * t[1] + d2 * t[0],
+			t[3] - 3.0 * d1 * t[2] + 3.0 * d2 * t[1] - d3 * t[0],
+			t[4] - 4.0 * d1 * t[3] + 6.0 * d2 * t[2] - 4.0 * d3 * t[1] + d4 * t[0]
+		};
+
+		for (auto& sum : timeSums)
+		{
+			sum *= decay;
+		}
+
+		// the new sample is at u = 0, so it only contributes to the zeroth sums
+		timeSums[0] += 1.0;
+
+		for (size_t i = 0; i < N; ++i)
+		{
+			const std::array<double, 3> v = valueSums[i];
+			std::array<double, 3>& sums = valueSums[i];
+
+			sums = {
+				v[0],
+				v[1] - d1 * v[0],
+				v[2] - 2.0 * d1 * v[1] + d2 * v[0]
+			};
+
+			for (auto& sum : sums)
+			{
+				sum *= decay;
+			}
+
+			sums[0] += value[i];
+		}
+	}
+
+	/**
+	 * \brief The rate of change of each dimension, per second, as of the newest sample.
+	 * Falls back to a linear fit until there are enough samples for a quadratic, and to zero before that.
+	 */
+	[[nodiscard]] std::array<double, N> velocity() const
+	{
+		std::array<double, N> result {};
+		solve(&result, nullptr);
+		return result;
+	}
+
+	/**
+	 * \brief The rate of change of the velocity of each dimension, per second, as of the newest sample.
+	 */
+	[[nodiscard]] std::array<double, N> acceleration() const
+	{
+		std::array<double, N> result {};
+		solve(nullptr, &result);
+		return result;
+	}
+
+private:
+	void solve(std::array<double, N>* velocity, std::array<double, N>* acceleration) const
+	{
+		// relative to the scale of the sums, so that degenerate fits (too few samples) are rejected in any unit of time
+		static constexpr double epsilon = 1e-9;
+
+		const std::array<double, 5>& t = timeSums;
+
+		// normal equations of x(u) = a + b*u + c*u^2, solved by Cramer's rule
+		const double quadratic = t[0] * (t[2] * t[4] - t[3] * t[3])
+		                       - t[1] * (t[1] * t[4] - t[3] * t[2])
+		                       + t[2] * (t[1] * t[3] - t[2] * t[2]);
+
+		if (std::abs(quadratic) > epsilon * t[0] * t[2] * t[4])
+		{
+			for (size_t i = 0; i < N; ++i)
+			{
+				const std::array<double, 3>& v = valueSums[i];
+
+				if (velocity != nullptr)
+				{
+					(*velocity)[i] = (t[0] * (v[1] * t[4] - t[3] * v[2])
+					                - v[0] * (t[1] * t[4] - t[3] * t[2])
+					                + t[2] * (t[1] * v[2] - v[1] * t[2])) / quadratic;
+				}
+
+				if (acceleration != nullptr)
+				{
+					(*acceleration)[i] = 2.0 * (t[0] * (t[2] * v[2] - v[1] * t[3])
+					                          - t[1] * (t[1] * v[2] - v[1] * t[2])
+					                          + v[0] * (t[1] * t[3] - t[2] * t[2])) / quadratic;
+				}
+			}
+
+			return;
+		}
+
+		const double linear = t[0] * t[2] - t[1] * t[1];
+
+		if (velocity != nullptr && std::abs(linear) > epsilon * t[0] * t[2])
+		{
+			for (size_t i = 0; i < N; ++i)
+			{
+				const std::array<double, 3>& v = valueSums[i];
+				(*velocity)[i] = (t[0] * v[1] - t[1] * v[0]) / linear;
+			}
+		}
+	}
+};
+
+/**
+ * \brief Tracks the motion of a device's touch points for gesture touch regions, updated once per input report
+ * from the newest sample of its \c Ds4TouchHistory.
+ * Each touch point has its own motion fit, and while both are held, so do the distance between them
+ * (for pinching) and their midpoint (for two-finger scrolling).
+ * \sa Ds4TouchRegionType
+ */
+class Ds4TouchGestures
+{
+public:
+	/**
+	 * \brief How long a flick remains active after the touch point that made it is released.
+	 */
+	static constexpr std::chrono::milliseconds flickDuration { 100 };
+
+private:
+	Ds4MotionFit<2> motion1;
+	Ds4MotionFit<2> motion2;
+	Ds4MotionFit<1> spread;
+	Ds4MotionFit<2> midpoint;
+
+	Ds4Buttons_t touching = 0;
+	bool hasSample = false;
+	Ds4TouchSample last {};
+
+public:
+	/**
+	 * \brief Adds the newest sample of a touch history.
+	 * \param history The touch history of the device.
+	 * \param held The touch points held as of the sample.
+	 */
+	void update(const Ds4TouchHistory& history, Ds4Buttons_t held);
+
+	/**
+	 * \brief Indicates if a touch point was held as of the last update.
+	 */
+	[[nodiscard]] bool isTouching(Ds4Buttons_t sender) const;
+
+	/**
+	 * \brief The sample of touch point 1 from the last update, whose timestamp is the time of that update.
+	 */
+	[[nodiscard]] const Ds4TouchSample& lastSample() const;
+
+	/**
+	 * \brief The velocity of a touch point in touchpad units per second.
+	 * Once the touch point is released, this is its velocity as of its release.
+	 */
+	[[nodiscard]] Vector2 velocity(Ds4Buttons_t sender) const;
+
+	/**
+	 * \brief The acceleration of a touch point in touchpad units per second squared.
+	 */
+	[[nodiscard]] Vector2 acceleration(Ds4Buttons_t sender) const;
+
+	/**
+	 * \brief The rate at which the touch points are moving apart in touchpad units per second,
+	 * or negative if they are moving together. Zero unless both are held.
+	 */
+	[[nodiscard]] float spreadVelocity() const;
+
+	/**
+	 * \brief The velocity of the midpoint of the touch points in touchpad units per second.
+	 * Zero unless both are held.
+	 */
+	[[nodiscard]] Vector2 midpointVelocity() const;
+
+private:
+	[[nodiscard]] const Ds4MotionFit<2>& motion(Ds4Buttons_t sender) const;
+	[[nodiscard]] static Vector2 toVector(const std::array<double, 2>& value);
+};
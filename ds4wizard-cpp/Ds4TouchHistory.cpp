@@ -0,0 +1,100 @@
+#include "pch.h"
+
+#include <algorithm>
+
+#include "Ds4TouchHistory.h"
+
+using namespace std::chrono;
+
+void Ds4TouchHistory::record(Stopwatch::TimePoint time, uint8_t frame, const Ds4Vector2& point1, const Ds4Vector2& point2)
+{
+	if (count == 0)
+	{
+		epoch = time;
+	}
+
+	const auto i = static_cast<uint32_t>(count++ & (capacity - 1));
+
+	timestamps[i] = static_cast<uint32_t>(duration_cast<microseconds>(time - epoch).count());
+	frames[i]     = frame;
+	points1[i]    = pack(point1);
+	points2[i]    = pack(point2);
+}
+
+bool Ds4TouchHistory::empty() const
+{
+	return count == 0;
+}
+
+uint64_t Ds4TouchHistory::newest() const
+{
+	return count - 1;
+}
+
+uint64_t Ds4TouchHistory::oldest() const
+{
+	return count > capacity ? count - capacity : 0;
+}
+
+Ds4TouchSample Ds4TouchHistory::get(Ds4Buttons_t sender, uint64_t sequence) const
+{
+	const auto i = static_cast<uint32_t>(sequence & (capacity - 1));
+
+	Ds4TouchSample result;
+	result.timestamp = timestamps[i];
+	result.frame     = frames[i];
+	result.point     = unpack((sender & Ds4Buttons::touch2) && !(sender & Ds4Buttons::touch1) ? points2[i] : points1[i]);
+
+	return result;
+}
+
+microseconds Ds4TouchHistory::elapsed(const Ds4TouchSample& from, const Ds4TouchSample& to)
+{
+	return microseconds(static_cast<int32_t>(to.timestamp - from.timestamp));
+}
+
+uint32_t Ds4TouchHistory::pack(const Ds4Vector2& point)
+{
+	return (static_cast<uint32_t>(point.x) & 0xFFF) | ((static_cast<uint32_t>(point.y) & 0xFFF) << 12);
+}
+
+Ds4Vector2 Ds4TouchHistory::unpack(uint32_t packed)
+{
+	return { static_cast<short>(packed & 0xFFF), static_cast<short>((packed >> 12) & 0xFFF) };
+}
+
+Ds4TouchHistoryView::Ds4TouchHistoryView(const Ds4TouchHistory* history, Ds4Buttons_t sender, uint64_t first)
+	: history(history),
+	  sender(sender),
+	  first(first)
+{
+}
+
+bool Ds4TouchHistoryView::empty() const
+{
+	return history == nullptr || history->empty();
+}
+
+Ds4TouchSample Ds4TouchHistoryView::newest() const
+{
+	return (*this)[size() - 1];
+}
+
+Ds4TouchSample Ds4TouchHistoryView::oldest() const
+{
+	return (*this)[0];
+}
+
+Ds4TouchSample Ds4TouchHistoryView::operator[](uint32_t index) const
+{
+	if (empty())
+	{
+		return {};
+	}
+
+	const uint64_t newest   = history->newest();
+	const uint64_t earliest = std::max(first, history->oldest());
+	const uint64_t age      = size() - 1 - index;
+
+	return history->get(sender, age < newest - earliest ? newest - age : earliest);
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+#include "enums.h"
+#include "Ds4InputData.h"
+#include "Stopwatch.h"
+
+/**
+ * \brief A single point of a \c Ds4TouchHistory.
+ */
+struct Ds4TouchSample
+{
+	/**
+	 * \brief Time of the sample in microseconds since the history began. Wraps roughly every 71 minutes,
+	 * so samples must only be compared by their difference. \sa Ds4TouchHistory::elapsed
+	 */
+	uint32_t timestamp = 0;
+
+	/**
+	 * \brief The frame counter of the input report the sample was taken from.
+	 */
+	uint8_t frame = 0;
+
+	Ds4Vector2 point {};
+};
+
+/**
+ * \brief The recent points of both touch points of a device, recorded once per input report.
+ * Samples are stored as parallel arrays of 32-bit timestamps, 8-bit frame counters
+ * and 12-bit packed coordinates, which are shared by every touch region of the device.
+ * \sa Ds4TouchHistoryView
+ */
+class Ds4TouchHistory
+{
+public:
+	/**
+	 * \brief The number of samples retained. Must be a power of two.
+	 */
+	static constexpr uint32_t capacity = 32;
+
+private:
+	/**
+	 * \brief The time of the first sample, from which timestamps are measured.
+	 */
+	Stopwatch::TimePoint epoch {};
+
+	std::array<uint32_t, capacity> timestamps {};
+	std::array<uint8_t, capacity> frames {};
+	std::array<uint32_t, capacity> points1 {};
+	std::array<uint32_t, capacity> points2 {};
+
+	/**
+	 * \brief The number of samples ever recorded. The newest sample is \c count - 1.
+	 */
+	uint64_t count = 0;
+
+public:
+	/**
+	 * \brief Records the touch points of an input report.
+	 * \param time The time the report was received.
+	 * \param frame The frame counter of the report.
+	 * \param point1 Touch point 1.
+	 * \param point2 Touch point 2.
+	 */
+	void record(Stopwatch::TimePoint time, uint8_t frame, const Ds4Vector2& point1, const Ds4Vector2& point2);
+
+	/**
+	 * \brief Indicates if no samples have been recorded.
+	 */
+	[[nodiscard]] bool empty() const;
+
+	/**
+	 * \brief The sequence number of the newest sample. Sequence numbers increase by one per sample.
+	 */
+	[[nodiscard]] uint64_t newest() const;
+
+	/**
+	 * \brief The sequence number of the oldest sample still retained.
+	 */
+	[[nodiscard]] uint64_t oldest() const;
+
+	/**
+	 * \brief Gets a sample of one touch point.
+	 * \param sender The touch point (touch 1, touch 2).
+	 * \param sequence The sequence number of the sample, between \c oldest and \c newest.
+	 */
+	[[nodiscard]] Ds4TouchSample get(Ds4Buttons_t sender, uint64_t sequence) const;
+
+	/**
+	 * \brief The time elapsed from sample \p from to sample \p to, handling wrap-around of timestamps.
+	 */
+	[[nodiscard]] static std::chrono::microseconds elapsed(const Ds4TouchSample& from, const Ds4TouchSample& to);
+
+private:
+	[[nodiscard]] static uint32_t pack(const Ds4Vector2& point);
+	[[nodiscard]] static Ds4Vector2 unpack(uint32_t packed);
+};
+
+/**
+ * \brief One touch point's view of a \c Ds4TouchHistory from the sample it activated a touch region.
+ * Samples from before then read as the activating sample, as if the history had been filled with it.
+ */
+class Ds4TouchHistoryView
+{
+	const Ds4TouchHistory* history = nullptr;
+	Ds4Buttons_t sender = 0;
+	uint64_t first = 0;
+
+public:
+	Ds4TouchHistoryView() = default;
+
+	/**
+	 * \brief Constructs a view of the samples of a touch point.
+	 * \param history The history to view.
+	 * \param sender The touch point (touch 1, touch 2).
+	 * \param first The sequence number of the activating sample.
+	 */
+	Ds4TouchHistoryView(const Ds4TouchHistory* history, Ds4Buttons_t sender, uint64_t first);
+
+	/**
+	 * \brief Indicates if the view has no history, in which case every sample reads as empty.
+	 */
+	[[nodiscard]] bool empty() const;
+
+	/**
+	 * \brief The number of samples in the view, i.e. \c Ds4TouchHistory::capacity.
+	 */
+	[[nodiscard]] static constexpr uint32_t size()
+	{
+		return Ds4TouchHistory::capacity;
+	}
+
+	[[nodiscard]] Ds4TouchSample newest() const;
+	[[nodiscard]] Ds4TouchSample oldest() const;
+
+	/**
+	 * \brief Gets a sample by age, where \c 0 is the oldest and \c size() - 1 the newest.
+	 */
+	Ds4TouchSample operator[](uint32_t index) const;
+};
@@ -3,6 +3,43 @@
 #include "InputSimulator.h"
 #include "ISimulator.h"
 
+namespace
+{
+	/**
+	 * \brief Gets the component of a gesture's velocity in a direction of the touchpad, where \p speed is full output.
+	 */
+	float getGestureAxis(const Vector2& velocity, Direction_t direction, float speed)
+	{
+		if (speed <= 0.0f)
+		{
+			return 0.0f;
+		}
+
+		const Vector2 scaled = velocity / speed;
+
+		switch (direction)
+		{
+			case Direction::up:
+				return std::clamp(-scaled.y, 0.0f, 1.0f);
+
+			case Direction::down:
+				return std::clamp(scaled.y, 0.0f, 1.0f);
+
+			case Direction::left:
+				return std::clamp(-scaled.x, 0.0f, 1.0f);
+
+			case Direction::right:
+				return std::clamp(scaled.x, 0.0f, 1.0f);
+
+			case Direction::none:
+				return std::min(scaled.length(), 1.0f);
+
+			default:
+				throw std::runtime_error("invalid Direction");
+		}
+	}
+}
+
 ISimulator* Ds4TouchRegion::getSimulator(InputSimulator* parent)
 {
 	ISimulator* result = nullptr;
@@ -30,6 +67,31 @@ ISimulator* Ds4TouchRegion::getSimulator(InputSimulator* parent)
 	return result;
 }
 
+void Ds4TouchRegion::setTouchHistory(const Ds4TouchHistory* history)
+{
+	touchHistory = history;
+}
+
+void Ds4TouchRegion::setTouchGestures(const Ds4TouchGestures* gestures)
+{
+	touchGestures = gestures;
+}
+
+bool Ds4TouchRegion::isGesture() const
+{
+	switch (type)
+	{
+		case Ds4TouchRegionType::swipe:
+		case Ds4TouchRegionType::flick:
+		case Ds4TouchRegionType::pinch:
+		case Ds4TouchRegionType::scroll:
+			return true;
+
+		default:
+			return false;
+	}
+}
+
 std::optional<PressedState> Ds4TouchRegion::getSimulatorState() const
 {
 	std::optional<PressedState> result;
@@ -79,6 +141,7 @@ Ds4TouchRegion::Ds4TouchRegion(const Ds4TouchRegion& other)
 	  top(other.top),
 	  right(other.right),
 	  bottom(other.bottom),
+	  gestureSpeed(other.gestureSpeed),
 	  touchAxisOptions(other.touchAxisOptions)
 {
 }
@@ -97,23 +160,14 @@ Ds4TouchRegion& Ds4TouchRegion::operator=(const Ds4TouchRegion& other)
 	top               = other.top;
 	right             = other.right;
 	bottom            = other.bottom;
+	gestureSpeed      = other.gestureSpeed;
 	touchAxisOptions  = other.touchAxisOptions;
 	
 	return *this;
 }
 
-bool Ds4TouchRegion::isInRegion(Ds4Buttons_t sender, const Ds4Vector2& point)
+bool Ds4TouchRegion::isInRegion(Ds4Buttons_t sender, const Ds4Vector2& point) const
 {
-	if (sender & Ds4Buttons::touch1)
-	{
-		points1.insert(Ds4TouchHistory(point));
-	}
-
-	if (sender & Ds4Buttons::touch2)
-	{
-		points2.insert(Ds4TouchHistory(point));
-	}
-	
 	if (point.x >= left && point.x <= right && point.y >= top && point.y <= bottom)
 	{
 		return true;
@@ -160,6 +214,10 @@ bool Ds4TouchRegion::isActive(Ds4Buttons_t sender, Direction_t direction) const
 		case Ds4TouchRegionType::stick:
 		case Ds4TouchRegionType::stickAutoCenter:
 		case Ds4TouchRegionType::trackball:
+		case Ds4TouchRegionType::swipe:
+		case Ds4TouchRegionType::flick:
+		case Ds4TouchRegionType::pinch:
+		case Ds4TouchRegionType::scroll:
 		{
 			// FIXME: do we really want this for an axis?
 			/*if (direction == Direction::none)
@@ -202,47 +260,55 @@ void Ds4TouchRegion::activateTouch(Ds4Buttons_t sender, const Ds4Vector2& point)
 
 	activeButtons |= sender & (Ds4Buttons::touch1 | Ds4Buttons::touch2);
 
+	// the history reads as this sample from here back, as though it were filled with it
+	const uint64_t sample = touchHistory != nullptr && !touchHistory->empty() ? touchHistory->newest() : 0;
+
 	if ((sender & Ds4Buttons::touch1) != 0)
 	{
-		pointStart1 = point;
-		points1.fill(Ds4TouchHistory(point));
+		pointStart1  = point;
+		firstSample1 = sample;
 	}
 	else if ((sender & Ds4Buttons::touch2) != 0)
 	{
-		pointStart2 = point;
-		points2.fill(Ds4TouchHistory(point));
+		pointStart2  = point;
+		firstSample2 = sample;
 	}
 }
 
-void Ds4TouchRegion::deactivateTouch(Ds4Buttons_t sender, Ds4Vector2 point)
+void Ds4TouchRegion::deactivateTouch(Ds4Buttons_t sender)
 {
+	// a flick is a touch point lifted off of the region while moving, not one which slid out of it
+	if (touchGestures != nullptr)
+	{
+		if ((sender & activeButtons & Ds4Buttons::touch1) && !touchGestures->isTouching(Ds4Buttons::touch1))
+		{
+			flickVelocity1 = touchGestures->velocity(Ds4Buttons::touch1);
+			flickSample1   = touchGestures->lastSample();
+		}
+
+		if ((sender & activeButtons & Ds4Buttons::touch2) && !touchGestures->isTouching(Ds4Buttons::touch2))
+		{
+			flickVelocity2 = touchGestures->velocity(Ds4Buttons::touch2);
+			flickSample2   = touchGestures->lastSample();
+		}
+	}
+
 	activeButtons &= ~(sender & (Ds4Buttons::touch1 | Ds4Buttons::touch2));
 
 	if ((sender & Ds4Buttons::touch1) != 0)
 	{
-		points1.insert(Ds4TouchHistory(point));
 		state1.release();
 	}
 
 	if ((sender & Ds4Buttons::touch2) != 0)
 	{
-		points2.insert(Ds4TouchHistory(point));
 		state2.release();
 	}
 }
 
 float Ds4TouchRegion::getSimulatedAxis(Ds4Buttons_t sender, Direction_t direction) const
 {
-	Ds4Vector2 point {};
-
-	if (sender & Ds4Buttons::touch1)
-	{
-		point = points1.newest().point;
-	}
-	else if (sender & Ds4Buttons::touch2)
-	{
-		point = points2.newest().point;
-	}
+	const Ds4Vector2 point = getPoints(sender).newest().point;
 
 	auto getVectorLength = [this, sender]() -> float
 	{
@@ -302,8 +368,9 @@ float Ds4TouchRegion::getSimulatedAxis(Ds4Buttons_t sender, Direction_t directio
 
 		case +Ds4TouchRegionType::trackball:
 		{
-			const Vector2 normalized = trackball->velocity.normalized();
-			const float length = trackball->velocity.length();
+			const Vector2 velocity   = trackball->interpolatedVelocity();
+			const Vector2 normalized = velocity.normalized();
+			const float length = velocity.length();
 			const float factor = trackball->settings.ballSpeed;
 
 			switch (direction)
@@ -335,6 +402,54 @@ float Ds4TouchRegion::getSimulatedAxis(Ds4Buttons_t sender, Direction_t directio
 			break;
 		}
 
+		case +Ds4TouchRegionType::swipe:
+		{
+			result = isTouchActive(sender) && touchGestures != nullptr
+			         ? getGestureAxis(touchGestures->velocity(sender), direction, gestureSpeed)
+			         : 0.0f;
+			break;
+		}
+
+		case +Ds4TouchRegionType::flick:
+		{
+			const bool first = (sender & Ds4Buttons::touch1) != 0;
+			const std::optional<Ds4TouchSample>& released = first ? flickSample1 : flickSample2;
+
+			result = 0.0f;
+
+			if (released.has_value() && touchGestures != nullptr &&
+			    Ds4TouchHistory::elapsed(*released, touchGestures->lastSample()) < Ds4TouchGestures::flickDuration)
+			{
+				result = getGestureAxis(first ? flickVelocity1 : flickVelocity2, direction, gestureSpeed);
+			}
+
+			break;
+		}
+
+		case +Ds4TouchRegionType::pinch:
+		case +Ds4TouchRegionType::scroll:
+		{
+			result = 0.0f;
+
+			// both touch points must be in this region, regardless of sender
+			if (touchGestures == nullptr || !isTouchActive(Ds4Buttons::touch1) || !isTouchActive(Ds4Buttons::touch2))
+			{
+				break;
+			}
+
+			if (type == +Ds4TouchRegionType::pinch)
+			{
+				// spreading apart reads as up, like zooming in
+				result = getGestureAxis(Vector2(0.0f, -touchGestures->spreadVelocity()), direction, gestureSpeed);
+			}
+			else
+			{
+				result = getGestureAxis(touchGestures->midpointVelocity(), direction, gestureSpeed);
+			}
+
+			break;
+		}
+
 		default:
 		{
 			x = static_cast<short>(x - left);
@@ -393,16 +508,16 @@ float Ds4TouchRegion::getSimulatedAxisWithOptionsApplied(Ds4Buttons_t sender, Di
 	return options.applyToValueWithMagnitude(value, magnitude);
 }
 
-const decltype(Ds4TouchRegion::points1)& Ds4TouchRegion::getPoints(Ds4Buttons_t sender) const
+Ds4TouchHistoryView Ds4TouchRegion::getPoints(Ds4Buttons_t sender) const
 {
 	if (sender & Ds4Buttons::touch1)
 	{
-		return points1;
+		return Ds4TouchHistoryView(touchHistory, Ds4Buttons::touch1, firstSample1);
 	}
 
 	if (sender & Ds4Buttons::touch2)
 	{
-		return points2;
+		return Ds4TouchHistoryView(touchHistory, Ds4Buttons::touch2, firstSample2);
 	}
 
 	throw;
@@ -415,6 +530,7 @@ bool Ds4TouchRegion::operator==(const Ds4TouchRegion& other) const
 	       && top == other.top
 	       && right == other.right
 	       && bottom == other.bottom
+	       && gestureSpeed == other.gestureSpeed
 	       && touchAxisOptions == other.touchAxisOptions;
 }
 
@@ -452,6 +568,13 @@ void Ds4TouchRegion::readJson(const nlohmann::json& json)
 	{
 		trackballSettings = std::make_shared<TrackballSettings>(fromJson<TrackballSettings>(*it));
 	}
+
+	it = json.find("gestureSpeed");
+
+	if (it != json.end())
+	{
+		gestureSpeed = *it;
+	}
 }
 
 void Ds4TouchRegion::writeJson(nlohmann::json& json) const
@@ -476,4 +599,9 @@ void Ds4TouchRegion::writeJson(nlohmann::json& json) const
 	{
 		json["trackballSettings"] = trackballSettings->toJson();
 	}
+
+	if (isGesture())
+	{
+		json["gestureSpeed"] = gestureSpeed;
+	}
 }
@@ -10,18 +10,14 @@
 #include "Pressable.h"
 #include "AxisOptions.h"
 #include "JsonData.h"
-#include "circular_buffer.h"
+#include "Ds4TouchGestures.h"
+#include "Ds4TouchHistory.h"
 #include "Trackball.h"
 
 // TODO: TrackPad - basically always auto-centering stick
 // TODO: Slider (maybe just "cursor", with toggle-able X and Y axes?)
 // TODO: Make auto-center an option instead of type?
 
-/*
- * How do we detect a touch pad flick?
- * - points[newest] - points[oldest], where points = circular buffer of last N touch points
- */
-
 BETTER_ENUM(Ds4TouchRegionType, int,
             /** \brief No type specified. Considered invalid. */
             none,
@@ -32,7 +28,15 @@ BETTER_ENUM(Ds4TouchRegionType, int,
             /** \brief Simulates an analog stick which scales. */
             stickAutoCenter,
             /** \brief Simulates a trackball which can roll over time. */
-            trackball)
+            trackball,
+            /** \brief Active in the direction a touch point is moving, scaled by its speed. */
+            swipe,
+            /** \brief Active briefly in the direction a touch point was moving when released, scaled by its speed. */
+            flick,
+            /** \brief Active up while two touch points spread apart and down while they pinch together, scaled by their speed. */
+            pinch,
+            /** \brief Active in the direction two touch points are moving together, scaled by their speed. */
+            scroll)
 
 class Ds4TouchRegion;
 
@@ -48,24 +52,6 @@ using Ds4TouchRegionCollection = std::map<std::string, Ds4TouchRegion>;
  */
 using Ds4TouchRegionCache = std::map<std::string, Ds4TouchRegion*>;
 
-struct Ds4TouchHistory
-{
-	using Clock     = std::chrono::high_resolution_clock;
-	using TimePoint = Clock::time_point;
-	using Duration  = Clock::duration;
-
-	TimePoint timestamp {};
-	Ds4Vector2 point {};
-
-	explicit Ds4TouchHistory(const Ds4Vector2& point)
-		: timestamp(Clock::now()),
-		  point(point)
-	{
-	}
-
-	Ds4TouchHistory() = default;
-};
-
 class InputSimulator;
 class ISimulator;
 
@@ -86,7 +72,30 @@ class Ds4TouchRegion : public JsonData
 	 */
 	Ds4Buttons_t activeButtons = 0;
 
-	circular_buffer<Ds4TouchHistory, 30> points1 {}, points2 {};
+	/**
+	 * \brief The touch history of the device this region is simulated on, if any.
+	 */
+	const Ds4TouchHistory* touchHistory = nullptr;
+
+	/**
+	 * \brief The sample of \c touchHistory at which each touch point last activated this region.
+	 */
+	uint64_t firstSample1 = 0;
+	uint64_t firstSample2 = 0;
+
+	/**
+	 * \brief The motion of the touch points of the device this region is simulated on, if any.
+	 */
+	const Ds4TouchGestures* touchGestures = nullptr;
+
+	/**
+	 * \brief The velocity of each touch point as of when it was last released from this region,
+	 * and when that was. \sa Ds4TouchRegionType::flick
+	 */
+	Vector2 flickVelocity1 {};
+	Vector2 flickVelocity2 {};
+	std::optional<Ds4TouchSample> flickSample1;
+	std::optional<Ds4TouchSample> flickSample2;
 
 	std::shared_ptr<TrackballSimulator> trackball;
 	std::shared_ptr<TrackballSettings> trackballSettings;
@@ -106,6 +115,24 @@ public:
 
 	ISimulator* getSimulator(InputSimulator* parent);
 
+	/**
+	 * \brief Sets the touch history this region reads touch points from.
+	 * \param history The touch history of the device, which must outlive this region.
+	 */
+	void setTouchHistory(const Ds4TouchHistory* history);
+
+	/**
+	 * \brief Sets the touch motion gesture regions read from.
+	 * \param gestures The touch motion of the device, which must outlive this region.
+	 */
+	void setTouchGestures(const Ds4TouchGestures* gestures);
+
+	/**
+	 * \brief Indicates if this region is one of the gesture types, which are driven by touch point motion
+	 * rather than position. \sa Ds4TouchGestures
+	 */
+	[[nodiscard]] bool isGesture() const;
+
 	[[nodiscard]] std::optional<PressedState> getSimulatorState() const;
 
 	/**
@@ -148,6 +175,12 @@ public:
 	 */
 	short bottom = 0;
 
+	/**
+	 * \brief The speed, in touchpad units per second, at which the output of a gesture region is at its maximum.
+	 * \sa isGesture
+	 */
+	float gestureSpeed = 2000.0f;
+
 	/**
 	 * \brief Axis configuration for swipe directions if applicable.
 	 */
@@ -178,9 +211,10 @@ public:
 	 * \brief Check if a point is within the bounds of this touch region.
 	 * \param sender The multi-touch sender (touch 1, touch 2).
 	 * \param point The point to check.
-	 * \return \c true if \a point is within the bounds of this touch region.
+	 * \return \c true if \a point is within the bounds of this touch region,
+	 * or if \a sender is already active in this region and it does not allow cross-over.
 	 */
-	bool isInRegion(Ds4Buttons_t sender, const Ds4Vector2& point);
+	[[nodiscard]] bool isInRegion(Ds4Buttons_t sender, const Ds4Vector2& point) const;
 
 	/**
 	 * \brief Get the starting coordinates that activated this touch region.
@@ -208,9 +242,8 @@ public:
 	/**
 	 * \brief De-activate the specified multi-touch senders in this region.
 	 * \param sender The multi-touch sender (touch 1, touch 2).
-	 * \param point The last point reported by the device.
 	 */
-	void deactivateTouch(Ds4Buttons_t sender, Ds4Vector2 point);
+	void deactivateTouch(Ds4Buttons_t sender);
 
 	// TODO: fix documentation for getSimulatedAxis/etc, as it is not always a touch delta that is returned.
 
@@ -230,8 +263,11 @@ public:
 	 */
 	[[nodiscard]] float getSimulatedAxisWithOptionsApplied(Ds4Buttons_t sender, Direction_t direction) const;
 
-	// FIXME: nice documentation, nerd!
-	[[nodiscard]] const decltype(points1)& getPoints(Ds4Buttons_t sender) const;
+	/**
+	 * \brief Get the touch history of a multi-touch sender since it last activated this region.
+	 * \param sender The multi-touch sender (touch 1, touch 2).
+	 */
+	[[nodiscard]] Ds4TouchHistoryView getPoints(Ds4Buttons_t sender) const;
 
 	bool operator==(const Ds4TouchRegion& other) const;
 	bool operator!=(const Ds4TouchRegion& other) const;
@@ -0,0 +1,57 @@
+#include "pch.h"
+
+#include <algorithm>
+
+#include "Ds4TouchRegionGrid.h"
+#include "Ds4TouchRegion.h"
+
+void Ds4TouchRegionGrid::build(const std::vector<Ds4TouchRegion*>& regions)
+{
+	words = (regions.size() + 63) / 64;
+	cells.assign(static_cast<size_t>(columns * rows) * words, 0);
+
+	for (size_t i = 0; i < regions.size(); ++i)
+	{
+		const Ds4TouchRegion& region = *regions[i];
+
+		if (region.right < region.left || region.bottom < region.top)
+		{
+			continue;
+		}
+
+		const uint64_t bit = 1ull << (i % 64);
+
+		for (int y = row(region.top); y <= row(region.bottom); ++y)
+		{
+			for (int x = column(region.left); x <= column(region.right); ++x)
+			{
+				cells[(static_cast<size_t>(y * columns + x) * words) + i / 64] |= bit;
+			}
+		}
+	}
+}
+
+void Ds4TouchRegionGrid::addCandidates(const Ds4Vector2& point, std::vector<uint64_t>& regions) const
+{
+	if (words == 0)
+	{
+		return;
+	}
+
+	const uint64_t* cell = &cells[static_cast<size_t>(row(point.y) * columns + column(point.x)) * words];
+
+	for (size_t i = 0; i < words; ++i)
+	{
+		regions[i] |= cell[i];
+	}
+}
+
+int Ds4TouchRegionGrid::column(int x)
+{
+	return std::clamp(x / cellSize, 0, columns - 1);
+}
+
+int Ds4TouchRegionGrid::row(int y)
+{
+	return std::clamp(y / cellSize, 0, rows - 1);
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Ds4InputData.h"
+
+class Ds4TouchRegion;
+
+/**
+ * \brief A coarse grid over the touchpad, where each cell holds a bitset of the touch regions overlapping it.
+ * Finding the regions which may contain a touch point is then a single lookup, regardless of how many
+ * regions there are. A cell's regions only overlap it, so a candidate must still be checked against its bounds.
+ * \sa Ds4TouchRegion::isInRegion
+ */
+class Ds4TouchRegionGrid
+{
+public:
+	/**
+	 * \brief The width of the touchpad. \sa Ds4Vector2::x
+	 */
+	static constexpr int touchpadWidth = 1920;
+
+	/**
+	 * \brief The height of the touchpad. \sa Ds4Vector2::y
+	 */
+	static constexpr int touchpadHeight = 943;
+
+	/**
+	 * \brief The width and height of each cell.
+	 */
+	static constexpr int cellSize = 64;
+
+	static constexpr int columns = (touchpadWidth + cellSize - 1) / cellSize;
+	static constexpr int rows    = (touchpadHeight + cellSize - 1) / cellSize;
+
+private:
+	/**
+	 * \brief The number of 64-bit words in the bitset of each cell.
+	 */
+	size_t words = 0;
+
+	/**
+	 * \brief The bitset of every cell, row by row.
+	 */
+	std::vector<uint64_t> cells;
+
+public:
+	/**
+	 * \brief Rebuilds the grid.
+	 * \param regions The touch regions to index. The position of each region is its ID within the grid.
+	 */
+	void build(const std::vector<Ds4TouchRegion*>& regions);
+
+	/**
+	 * \brief Adds every region which may contain a point to a bitset of region IDs.
+	 * Points outside the touchpad are treated as being on its nearest edge.
+	 * \param point The point to look up.
+	 * \param regions The bitset to add to, with at least as many words as the grid.
+	 */
+	void addCandidates(const Ds4Vector2& point, std::vector<uint64_t>& regions) const;
+
+private:
+	[[nodiscard]] static int column(int x);
+	[[nodiscard]] static int row(int y);
+};
@@ -28,6 +28,12 @@ private:
 	std::deque<weak_callback> callbacks;
 	std::recursive_mutex mutex;
 
+	/**
+	 * \brief The number of \c invoke calls in progress, which may be nested if a listener raises the event.
+	 * While non-zero, \c callbacks is never erased from so that it can be iterated without copying it.
+	 */
+	size_t invokeDepth = 0;
+
 public:
 	/**
 	 * \brief Registers a listener callback function with the event.
@@ -51,10 +57,24 @@ public:
 	{
 		std::lock_guard lock(mutex);
 
-		callbacks.erase(std::remove_if(callbacks.begin(), callbacks.end(), [token](auto ptr) -> bool
+		if (invokeDepth > 0)
+		{
+			// expire the callback instead; it is erased by the next invoke which isn't nested
+			for (auto& weak : callbacks)
+			{
+				if (weak.lock() == token)
+				{
+					weak.reset();
+				}
+			}
+
+			return;
+		}
+
+		callbacks.erase(std::remove_if(callbacks.begin(), callbacks.end(), [&token](const weak_callback& ptr) -> bool
 		{
 			return ptr.lock() == token;
-		}));
+		}), callbacks.end());
 	}
 
 	/**
@@ -66,19 +86,33 @@ public:
 	{
 		std::lock_guard lock(mutex);
 
-		auto predicate = [](weak_callback t) -> bool
+		if (invokeDepth == 0)
+		{
+			auto predicate = [](const weak_callback& t) -> bool
+			{
+				return t.expired();
+			};
+
+			callbacks.erase(std::remove_if(callbacks.begin(), callbacks.end(), predicate), callbacks.end());
+		}
+
+		struct DepthGuard
 		{
-			return t.expired();
-		};
+			size_t& depth;
 
-		callbacks.erase(std::remove_if(callbacks.begin(), callbacks.end(), predicate), callbacks.end());
+			~DepthGuard()
+			{
+				--depth;
+			}
+		} guard { ++invokeDepth };
 
-		// Copied so that callbacks can register new callbacks or unregister callbacks.
-		auto callbacksCopy = callbacks;
+		// Iterated by index up to the current count so that callbacks can register new callbacks,
+		// which are not notified until the next invocation, or unregister callbacks (see remove).
+		const size_t count = callbacks.size();
 
-		for (auto weak : callbacksCopy)
+		for (size_t i = 0; i < count; ++i)
 		{
-			if (auto shared = weak.lock())
+			if (auto shared = callbacks[i].lock())
 			{
 				(*shared)(sender, args...);
 			}
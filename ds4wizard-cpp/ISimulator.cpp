@@ -16,6 +16,16 @@ void ISimulator::activate(float deltaTime)
 	}
 }
 
+std::optional<Stopwatch::Duration> ISimulator::timeUntilUpdate() const
+{
+	return timeUntilStep(continuousInterval);
+}
+
+Stopwatch::Duration ISimulator::timeUntilStep(Stopwatch::Duration interval) const
+{
+	return std::max(Stopwatch::Duration::zero(), interval - lastUpdate.elapsed());
+}
+
 void ISimulator::deactivate(float deltaTime)
 {
 	if (state == SimulatorState::active)
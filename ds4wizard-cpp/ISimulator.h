@@ -1,5 +1,9 @@
 #pragma once
 
+#include <optional>
+
+#include "Stopwatch.h"
+
 class InputSimulator;
 
 enum class SimulatorState
@@ -11,9 +15,19 @@ enum class SimulatorState
 class ISimulator
 {
 public:
+	/**
+	 * \brief How often a simulator which requests continuous updates is updated in the absence of new input.
+	 */
+	static constexpr std::chrono::milliseconds continuousInterval { 1 };
+
 	SimulatorState state;
 	InputSimulator* parent;
 
+	/**
+	 * \brief Started each time the parent updates this simulator. \sa timeUntilStep
+	 */
+	Stopwatch lastUpdate;
+
 	explicit ISimulator(InputSimulator* parent);
 	virtual ~ISimulator() = default;
 
@@ -21,7 +35,20 @@ public:
 	virtual void update(float deltaTime) = 0;
 	void deactivate(float deltaTime);
 
+	/**
+	 * \brief Gets the time remaining until this simulator needs to be updated
+	 * in the absence of new input, or \c std::nullopt if it has nothing to do until then.
+	 * The default implementation requests continuous updates every \c continuousInterval.
+	 */
+	[[nodiscard]] virtual std::optional<Stopwatch::Duration> timeUntilUpdate() const;
+
+protected:
+	/**
+	 * \brief Gets the time remaining until \p interval has passed since the last update, or zero if it already has.
+	 */
+	[[nodiscard]] Stopwatch::Duration timeUntilStep(Stopwatch::Duration interval) const;
+
 private:
-	virtual void onActivate(float deltaTime) {}
-	virtual void onDeactivate(float deltaTime) {}
+	virtual void onActivate(float /*deltaTime*/) {}
+	virtual void onDeactivate(float /*deltaTime*/) {}
 };
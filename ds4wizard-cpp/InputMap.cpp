@@ -42,6 +42,32 @@ bool InputMapBase::isPersistent() const
 	return rapidFire == true;
 }
 
+std::optional<Stopwatch::Duration> InputMapBase::timeUntilUpdate() const
+{
+	if (!isPersistent())
+	{
+		return std::nullopt;
+	}
+
+	// pressed and released must advance to on and off respectively
+	if (rapidState == PressedState::pressed || rapidState == PressedState::released)
+	{
+		return Stopwatch::Duration::zero();
+	}
+
+	if (!isActive())
+	{
+		return std::nullopt;
+	}
+
+	if (!rapidFireInterval.has_value())
+	{
+		return Stopwatch::Duration::zero();
+	}
+
+	return std::max(Stopwatch::Duration::zero(), Stopwatch::Duration(*rapidFireInterval) - rapidStopwatch.elapsed());
+}
+
 InputMapBase::InputMapBase(const InputMapBase& other)
 	: Pressable(other),
 	  inputType(other.inputType),
@@ -49,6 +75,7 @@ InputMapBase::InputMapBase(const InputMapBase& other)
 	  inputAxes(other.inputAxes),
 	  inputTouchRegion(other.inputTouchRegion),
 	  inputTouchDirection(other.inputTouchDirection),
+	  inputTrigger(other.inputTrigger),
 	  toggle(other.toggle),
 	  rapidFire(other.rapidFire),
 	  rapidFireInterval(other.rapidFireInterval),
@@ -63,6 +90,7 @@ InputMapBase::InputMapBase(InputMapBase&& other) noexcept
 	  inputAxes(other.inputAxes),
 	  inputTouchRegion(std::move(other.inputTouchRegion)),
 	  inputTouchDirection(other.inputTouchDirection),
+	  inputTrigger(std::move(other.inputTrigger)),
 	  toggle(other.toggle),
 	  rapidFire(other.rapidFire),
 	  rapidFireInterval(other.rapidFireInterval),
@@ -100,6 +128,7 @@ InputMapBase& InputMapBase::operator=(InputMapBase&& other) noexcept
 	inputAxes           = other.inputAxes;
 	inputTouchRegion    = std::move(other.inputTouchRegion);
 	inputTouchDirection = other.inputTouchDirection;
+	inputTrigger        = std::move(other.inputTrigger);
 	toggle              = other.toggle;
 	rapidFire           = other.rapidFire;
 	rapidFireInterval   = other.rapidFireInterval;
@@ -184,13 +213,15 @@ void InputMapBase::release()
 	}
 }
 
-InputAxisOptions InputMapBase::getAxisOptions(Ds4Axes_t axis) const
+const InputAxisOptions& InputMapBase::getAxisOptions(Ds4Axes_t axis) const
 {
+	static const InputAxisOptions defaultOptions;
+
 	const auto it = inputAxisOptions.find(axis);
 
 	if (it == inputAxisOptions.end())
 	{
-		return InputAxisOptions();
+		return defaultOptions;
 	}
 
 	return it->second;
@@ -203,6 +234,7 @@ bool InputMapBase::operator==(const InputMapBase& other) const
 	       && inputAxes == other.inputAxes
 	       && inputTouchRegion == other.inputTouchRegion
 	       && inputTouchDirection == other.inputTouchDirection
+	       && inputTrigger == other.inputTrigger
 	       && toggle == other.toggle
 	       && rapidFire == other.rapidFire
 	       && rapidFireInterval == other.rapidFireInterval
@@ -249,6 +281,11 @@ void InputMapBase::readJson(const nlohmann::json& json)
 		inputTouchDirection = touchDirection_;
 	}
 
+	if (json.find("inputTrigger") != json.end())
+	{
+		inputTrigger = fromJson<InputTrigger>(json["inputTrigger"]);
+	}
+
 	if (json.find("toggle") != json.end())
 	{
 		toggle = json["toggle"];
@@ -301,6 +338,11 @@ void InputMapBase::writeJson(nlohmann::json& json) const
 		json["inputTouchDirection"] = ENUM_SERIALIZE_FLAGS(Direction)(inputTouchDirection.value()).c_str();
 	}
 
+	if (inputTrigger.has_value())
+	{
+		json["inputTrigger"] = inputTrigger->toJson();
+	}
+
 	if (toggle.has_value())
 	{
 		json["toggle"] = toggle.value();
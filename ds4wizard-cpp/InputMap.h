@@ -7,6 +7,7 @@
 #include "Pressable.h"
 #include "Stopwatch.h"
 #include "AxisOptions.h"
+#include "InputTrigger.h"
 
 class InputMapBase : public Pressable, public JsonData
 {
@@ -39,12 +40,20 @@ public:
 	 */
 	[[nodiscard]] bool isPersistent() const;
 
+	/**
+	 * \brief Gets the time remaining until this persistent instance's simulated state
+	 * changes on its own, or \c std::nullopt if it won't change without new input.
+	 * \sa isPersistent
+	 */
+	[[nodiscard]] std::optional<Stopwatch::Duration> timeUntilUpdate() const;
+
 	InputType_t inputType = 0;
 
 	std::optional<Ds4Buttons_t> inputButtons;
 	std::optional<Ds4Axes_t> inputAxes;
 	std::string inputTouchRegion;
 	std::optional<Direction_t> inputTouchDirection;
+	std::optional<InputTrigger> inputTrigger;
 
 	std::optional<bool> toggle;
 	std::optional<bool> rapidFire;
@@ -72,7 +81,7 @@ protected:
 
 public:
 	void release() override;
-	InputAxisOptions getAxisOptions(Ds4Axes_t axis) const;
+	[[nodiscard]] const InputAxisOptions& getAxisOptions(Ds4Axes_t axis) const;
 
 	bool operator==(const InputMapBase& other) const;
 	bool operator!=(const InputMapBase& other) const;
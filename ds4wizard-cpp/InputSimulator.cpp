@@ -1,24 +1,32 @@
 #include "pch.h"
 
+#include <bit>
 #include <chrono>
 #include <unordered_set>
 
-#include "Ds4Device.h"
 #include "InputSimulator.h"
 #include "XInputRumbleSimulator.h"
 #include "RumbleSequence.h"
+#include "TickClock.h"
 
 using namespace std::chrono;
 
-InputSimulator::InputSimulator(Ds4Device* parent)
-	: parent(parent)
+InputSimulator::InputSimulator(const Ds4Input& input, Ds4Output& output, const InputSimulatorSinks& sinks)
+	: input(input),
+	  output(output),
+	  sinks(sinks),
+	  activeProfile(std::make_unique<CompiledProfile>(DeviceProfile(), this))
 {
-	xinputTargetOpen();
+	if (sinks.virtualPad != nullptr)
+	{
+		xinputRumbleSimulator = std::make_unique<XInputRumbleSimulator>(this, sinks.virtualPad);
+	}
 }
 
 InputSimulator::~InputSimulator()
 {
-	xinputDisconnect();
+	delete pendingProfile.exchange(nullptr);
+	delete retiredProfile.exchange(nullptr);
 }
 
 void InputSimulator::start()
@@ -26,6 +34,36 @@ void InputSimulator::start()
 	deltaStopwatch.start();
 }
 
+void InputSimulator::setHeadless(bool headless)
+{
+	headless_ = headless;
+
+	if (headless)
+	{
+		xinputDisconnect();
+	}
+}
+
+bool InputSimulator::headless() const
+{
+	return headless_;
+}
+
+const Ds4TouchHistory& InputSimulator::touchHistory() const
+{
+	return touchHistory_;
+}
+
+const Ds4TouchGestures& InputSimulator::touchGestures() const
+{
+	return touchGestures_;
+}
+
+const XInputGamepad& InputSimulator::xinputState() const
+{
+	return xinputPad;
+}
+
 void InputSimulator::simulateXInputButton(XInputButtons_t buttons, PressedState state)
 {
 	XInputButtons_t dest = xinputPad.wButtons;
@@ -60,7 +98,7 @@ void InputSimulator::simulateXInputAxis(const XInputAxes& axes, float m)
 			continue;
 		}
 
-		AxisOptions options = axes.getAxisOptions(static_cast<XInputAxis::T>(bit));
+		const AxisOptions& options = axes.getAxisOptions(static_cast<XInputAxis::T>(bit));
 
 		const auto trigger = static_cast<uint8_t>(255.0f * m);
 
@@ -129,116 +167,43 @@ void InputSimulator::simulateXInputAxis(const XInputAxes& axes, float m)
 	}
 }
 
-bool InputSimulator::isOverriddenByModifierSet(const InputMapBase& map)
+bool InputSimulator::isOverriddenByModifierSet(const InputMapBase& map, const BindingPlanSource& source, bool modifierBinding)
 {
-	if (modifierMaps.empty())
+	if (suppressionDirty)
 	{
-		return false;
+		updateSuppression();
 	}
 
-	auto checkButtonMap = [&](InputMap const* m) -> bool
-	{
-		return m->isActive() &&
-		       m != &map &&
-		       !!(m->inputButtons.value_or(0) & map.inputButtons.value());
-	};
-
-	auto checkAxisMap = [&](InputMap const* m) -> bool
-	{
-		return m->isActive() &&
-		       m != &map &&
-		       !!(m->inputAxes.value_or(0) & map.inputAxes.value());
-	};
+	// an active modifier binding has claimed its own inputs, which must not count against it
+	return suppression.suppresses(source, modifierBinding && map.isActive());
+}
 
-	auto checkTouchMap = [&](InputMap const* m) -> bool
-	{
-		return m->isActive() && m != &map;
-	};
+void InputSimulator::updateSuppression()
+{
+	suppression.reset(activeProfile->plan.touchRegionCount);
 
-	for (auto& pair : modifierMaps)
+	for (const BindingPlanOp& op : activeProfile->plan.modifierBindings)
 	{
-		auto& cache = pair.second;
-		cache.reset();
-
-		if (map.inputType & InputType::button && map.inputButtons.value_or(0) != 0)
+		if (op.map->isActive())
 		{
-			const auto buttons = map.inputButtons.value_or(0);
-
-			for (const Ds4Buttons_t bit : Ds4Buttons_values)
-			{
-				if (!(bit & buttons))
-				{
-					continue;
-				}
-
-				auto* collection = cache.getButtonMaps(bit);
-
-				if (collection == nullptr)
-				{
-					continue;
-				}
-
-				if (std::ranges::any_of(std::as_const(*collection), checkButtonMap))
-				{
-					return true;
-				}
-			}
-		}
-
-		if (map.inputType & InputType::axis && map.inputAxes.value_or(0) != 0)
-		{
-			const auto axes = map.inputAxes.value();
-
-			for (const Ds4Axes_t bit : Ds4Axes_values)
-			{
-				if (!(bit & axes))
-				{
-					continue;
-				}
-
-				auto* collection = cache.getAxisMaps(bit);
-
-				if (collection == nullptr)
-				{
-					continue;
-				}
-
-				if (std::ranges::any_of(std::as_const(*collection), checkAxisMap))
-				{
-					return true;
-				}
-			}
-		}
-
-		if (map.inputType & InputType::touchRegion && !map.inputTouchRegion.empty())
-		{
-			auto* collection = cache.getTouchMaps(map.inputTouchRegion);
-
-			if (collection == nullptr)
-			{
-				continue;
-			}
-
-			if (std::ranges::any_of(std::as_const(*collection), checkTouchMap))
-			{
-				return true;
-			}
+			suppression.add(op.source);
 		}
 	}
 
-	return false;
+	suppressionDirty = false;
 }
 
 float InputSimulator::getAxisWithOptionsApplied(Ds4Axes_t axes, const InputAxisOptions& options) const
 {
-	const Ds4Axes_t expanded = Ds4Axes::expand(axes);
+	const auto& values = input.getAllAxes();
+	const float value = Ds4Input::applyPolarity(values[Ds4Input::axisIndex(axes)], options.polarity);
 
-	if (expanded & (Ds4Axes::leftStick | Ds4Axes::rightStick))
+	if (axes & (Ds4Axes::leftStick | Ds4Axes::rightStick))
 	{
-		Ds4Buttons_t x_axis;
-		Ds4Buttons_t y_axis;
+		Ds4Axes_t x_axis;
+		Ds4Axes_t y_axis;
 
-		if (expanded & Ds4Axes::leftStick)
+		if (axes & Ds4Axes::leftStick)
 		{
 			x_axis = Ds4Axes::leftStickX;
 			y_axis = Ds4Axes::leftStickY;
@@ -249,21 +214,22 @@ float InputSimulator::getAxisWithOptionsApplied(Ds4Axes_t axes, const InputAxisO
 			y_axis = Ds4Axes::rightStickY;
 		}
 
-		const Vector2 stick(parent->input.getAxis(x_axis, std::nullopt),
-		                    parent->input.getAxis(y_axis, std::nullopt));
-
-		const float value = parent->input.getAxis(axes, options.polarity);
+		const Vector2 stick(values[Ds4Input::axisIndex(x_axis)],
+		                    values[Ds4Input::axisIndex(y_axis)]);
 
 		// applyToValue will automatically check the mode to see if we actually need to use
 		// the magnitude of the stick.
 		return options.applyToValue(value, stick);
 	}
 
-	return options.applyToValue(parent->input.getAxis(axes, options.polarity));
+	return options.applyToValue(value);
 }
 
-void InputSimulator::runMap(const InputMap& m, InputModifier const* modifier)
+void InputSimulator::runMap(const BindingPlanOp& op)
 {
+	const InputMap& m = *op.map;
+	InputModifier const* modifier = op.modifier;
+
 	if (m.inputType == 0)
 	{
 		throw std::out_of_range("inputType must be non-zero.");
@@ -280,6 +246,7 @@ void InputSimulator::runMap(const InputMap& m, InputModifier const* modifier)
 		switch (value)
 		{
 			case InputType::button:
+			case InputType::trigger:
 			{
 				const PressedState state = m.simulatedState();
 				applyMap(m, modifier, state, m.isActive() && ((modifier && modifier->isActive()) || m.isToggled) ? 1.0f : 0.0f);
@@ -288,21 +255,14 @@ void InputSimulator::runMap(const InputMap& m, InputModifier const* modifier)
 
 			case InputType::axis:
 			{
-				if (m.inputAxes.value_or(0) == 0)
+				if (op.source.axes == 0)
 				{
 					throw std::invalid_argument("inputAxes has no value");
 				}
 
-				for (Ds4Axes_t bit : Ds4Axes_values)
+				for (const BindingPlanAxis& axis : activeProfile->plan.getAxes(op.source))
 				{
-					if (!(m.inputAxes.value() & bit))
-					{
-						continue;
-					}
-
-					InputAxisOptions options = m.getAxisOptions(bit);
-
-					const float analog = getAxisWithOptionsApplied(m.inputAxes.value(), options);
+					const float analog = getAxisWithOptionsApplied(axis.axis, axis.options);
 					const PressedState state = m.simulatedState();
 					applyMap(m, modifier, state, analog);
 				}
@@ -312,7 +272,12 @@ void InputSimulator::runMap(const InputMap& m, InputModifier const* modifier)
 
 			case InputType::touchRegion:
 			{
-				Ds4TouchRegion* region = touchRegions[m.inputTouchRegion];
+				Ds4TouchRegion* region = op.source.touchRegion;
+
+				if (region == nullptr)
+				{
+					return;
+				}
 
 				if (region->type == +Ds4TouchRegionType::button)
 				{
@@ -356,6 +321,16 @@ void InputSimulator::runMap(const InputMap& m, InputModifier const* modifier)
 
 					applyMap(m, modifier, state, analog);
 				}
+				else if (region->isGesture())
+				{
+					// pinch and scroll read both touch points either way; swipe and flick take whichever is stronger
+					const Direction_t direction = m.inputTouchDirection.value_or(Direction::none);
+
+					const float analog = std::max(region->getSimulatedAxisWithOptionsApplied(Ds4Buttons::touch1, direction),
+					                              region->getSimulatedAxisWithOptionsApplied(Ds4Buttons::touch2, direction));
+
+					applyMap(m, modifier, m.simulatedState(), analog);
+				}
 				else
 				{
 					throw std::out_of_range("unhandled Ds4TouchRegionType");
@@ -370,7 +345,7 @@ void InputSimulator::runMap(const InputMap& m, InputModifier const* modifier)
 	}
 }
 
-void InputSimulator::applyProfile(DeviceProfile* profile)
+void InputSimulator::applyProfile(std::unique_ptr<CompiledProfile> profile)
 {
 	for (ISimulator* simulator : simulators)
 	{
@@ -379,31 +354,30 @@ void InputSimulator::applyProfile(DeviceProfile* profile)
 
 	simulators.clear();
 
-	touchRegions.clear();
-	sortableTouchRegions.clear();
+	std::unique_ptr<CompiledProfile> previous = std::exchange(activeProfile, std::move(profile));
+	delete retiredProfile.exchange(previous.release(), std::memory_order_acq_rel);
 
-	for (auto& pair : profile->touchRegions)
+	for (ISimulator* simulator : activeProfile->regionSimulators)
 	{
-		touchRegions[pair.first] = &pair.second;
-		sortableTouchRegions.emplace_back(&pair.second);
-		addSimulator(pair.second.getSimulator(this));
+		addSimulator(simulator);
 	}
 
-	bindings.clear();
-	modifiers.clear();
-	modifierMaps.clear();
+	const BindingPlan& plan = activeProfile->plan;
+	const size_t opCount = std::max(plan.modifiers.size(), plan.bindings.size());
 
-	bindings.cache(profile->bindings, touchRegions);
-	modifiers.cache(profile->modifiers, touchRegions);
+	pendingModifiers.resize(opCount);
+	pendingBindings.resize(opCount);
+	dirtyOps.resize(opCount);
 
-	for (auto& modifier : profile->modifiers)
-	{
-		MapCacheCollection<InputMap> mapCache;
-		mapCache.cache(modifier.bindings, touchRegions);
-		modifierMaps[&modifier] = std::move(mapCache);
-	}
+	const size_t touchRegionWords = (activeProfile->touchRegionsById.size() + 63) / 64;
+
+	liveTouchRegions.assign(touchRegionWords, 0);
+	visitedTouchRegions.assign(touchRegionWords, 0);
 
-	if (profile->useXInput)
+	fullUpdatePending = true;
+	suppressionDirty  = true;
+
+	if (activeProfile->profile.useXInput && !headless_)
 	{
 		if (!xinputConnect())
 		{
@@ -532,11 +506,19 @@ void InputSimulator::simulateMouse(const InputMap& m, PressedState state, float
 		switch (state)
 		{
 			case PressedState::pressed:
-				mouse.buttonDown(m.mouseButton.value());
+				if (IMouseSink* mouse = mouseSink())
+				{
+					mouse->buttonDown(m.mouseButton.value());
+				}
+
 				break;
 
 			case PressedState::released:
-				mouse.buttonUp(m.mouseButton.value());
+				if (IMouseSink* mouse = mouseSink())
+				{
+					mouse->buttonUp(m.mouseButton.value());
+				}
+
 				break;
 
 			default:
@@ -589,9 +571,11 @@ void InputSimulator::simulateMouse(const InputMap& m, PressedState state, float
 		y = 0;
 	}
 
-	if (x != 0 || y != 0)
+	IMouseSink* mouse = mouseSink();
+
+	if ((x != 0 || y != 0) && mouse != nullptr)
 	{
-		MouseSimulator::moveBy(x, y);
+		mouse->moveBy(x, y);
 	}
 }
 
@@ -602,31 +586,38 @@ void InputSimulator::simulateKeyboard(const InputMap& m, PressedState state)
 		return;
 	}
 
+	IKeyboardSink* keyboard = keyboardSink();
+
+	if (keyboard == nullptr)
+	{
+		return;
+	}
+
 	const VirtualKeyCode keyCode = m.keyCode.value();
 
 	switch (state)
 	{
 		case PressedState::pressed:
-			keyboard.keyDown(keyCode);
+			keyboard->keyDown(keyCode);
 
 			if (!m.keyCodeModifiers.empty())
 			{
 				for (VirtualKeyCode k : m.keyCodeModifiers)
 				{
-					keyboard.keyDown(k);
+					keyboard->keyDown(k);
 				}
 			}
 
 			break;
 
 		case PressedState::released:
-			keyboard.keyUp(keyCode);
+			keyboard->keyUp(keyCode);
 
 			if (!m.keyCodeModifiers.empty())
 			{
 				for (VirtualKeyCode k : m.keyCodeModifiers)
 				{
-					keyboard.keyUp(k);
+					keyboard->keyUp(k);
 				}
 			}
 
@@ -639,80 +630,105 @@ void InputSimulator::simulateKeyboard(const InputMap& m, PressedState state)
 
 void InputSimulator::runAction(ActionType action) const
 {
-	switch (action)
+	if (sinks.actions != nullptr && !headless_)
 	{
-		case ActionType::bluetoothDisconnect:
-			if (parent->bluetoothConnected())
-			{
-				parent->disconnectBluetooth(Ds4Device::BluetoothDisconnectReason::none);
-			}
+		sinks.actions->runAction(action);
+	}
+}
 
-			break;
+IKeyboardSink* InputSimulator::keyboardSink() const
+{
+	return headless_ ? nullptr : sinks.keyboard;
+}
 
-		default:
-			throw std::out_of_range("invalid ActionType");
-	}
+IMouseSink* InputSimulator::mouseSink() const
+{
+	return headless_ ? nullptr : sinks.mouse;
 }
 
 void InputSimulator::updateDeltaTime()
 {
-	deltaTime = static_cast<float>(duration_cast<milliseconds>(deltaStopwatch.elapsed()).count()) / deltaTimeTarget;
+	// not truncated to whole milliseconds, which would make anything integrated over it jitter with report timing
+	deltaTime = duration<float, std::milli>(deltaStopwatch.elapsed()).count() / deltaTimeTarget;
 	deltaStopwatch.start();
 }
 
 void InputSimulator::updateModifierStates()
 {
-	auto visitor = [&](InputModifier* m) -> bool
-	{
-		return updateModifierState(*m);
-	};
+	collectDirtyOps(activeProfile->plan.modifierIndex, activeProfile->plan.modifiers.size(), pendingModifiers);
+	pendingModifiers.clear();
 
-	for (const Ds4Buttons_t bit : Ds4Buttons_values)
+	dirtyOps.forEach([&](uint32_t i)
 	{
-		modifiers.visitButtonMaps(bit, visitor);
-	}
+		const ModifierPlanOp& op = activeProfile->plan.modifiers[i];
+		updateModifierState(op);
 
-	for (const Ds4Axes_t bit : Ds4Axes_values)
-	{
-		modifiers.visitAxisMaps(bit, visitor);
-	}
+		const bool settled = isSettled(*op.modifier) &&
+		                     std::ranges::all_of(activeProfile->plan.getBindings(op), [](const BindingPlanOp& bindingOp) { return isSettled(*bindingOp.map); });
 
-	for (auto& pair : touchRegions)
-	{
-		modifiers.visitTouchMaps(pair.first, visitor);
-	}
+		if (!settled)
+		{
+			pendingModifiers.insert(i);
+		}
+	});
 }
 
 void InputSimulator::updateBindingStates()
 {
-	auto visitor = [&](InputMap* m) -> bool
-	{
-		return updateBindingState(*m, nullptr);
-	};
+	collectDirtyOps(activeProfile->plan.bindingIndex, activeProfile->plan.bindings.size(), pendingBindings);
+	pendingBindings.clear();
 
-	for (const Ds4Buttons_t bit : Ds4Buttons_values)
+	dirtyOps.forEach([&](uint32_t i)
 	{
-		bindings.visitButtonMaps(bit, visitor);
-	}
+		const BindingPlanOp& op = activeProfile->plan.bindings[i];
+		updateBindingState(op);
 
-	for (const Ds4Axes_t bit : Ds4Axes_values)
-	{
-		bindings.visitAxisMaps(bit, visitor);
-	}
+		if (!isSettled(*op.map))
+		{
+			pendingBindings.insert(i);
+		}
+	});
+}
 
-	for (auto& pair : touchRegions)
+void InputSimulator::collectDirtyOps(const BindingPlanIndex& index, size_t count, const BindingPlanOpSet& pending)
+{
+	if (fullUpdate)
 	{
-		bindings.visitTouchMaps(pair.first, visitor);
+		dirtyOps.clear();
+		dirtyOps.insertAll(count);
+		return;
 	}
+
+	dirtyOps.assign(pending);
+	index.collect(input.pressedButtons | input.releasedButtons, input.axes, touchDirty, dirtyOps);
+}
+
+bool InputSimulator::isSettled(PressedState state) // static
+{
+	return state == PressedState::on || state == PressedState::off;
+}
+
+bool InputSimulator::isSettled(const InputMapBase& map) // static
+{
+	return isSettled(map.pressedState) && isSettled(map.simulatedState());
+}
+
+void InputSimulator::publishProfile(std::unique_ptr<CompiledProfile> profile)
+{
+	delete retiredProfile.exchange(nullptr, std::memory_order_acq_rel);
+	delete pendingProfile.exchange(profile.release(), std::memory_order_acq_rel);
 }
 
 void InputSimulator::startTick()
 {
-	parent->output.leftMotor  = 0;
-	parent->output.rightMotor = 0;
+	// a tick boundary, so the previous profile is no longer in use
+	if (pendingProfile.load(std::memory_order_relaxed) != nullptr)
+	{
+		applyProfile(std::unique_ptr<CompiledProfile>(pendingProfile.exchange(nullptr, std::memory_order_acq_rel)));
+	}
 
-	bindings.reset();
-	modifiers.reset();
+	output.leftMotor  = 0;
+	output.rightMotor = 0;
 
 	updateDeltaTime();
 	
@@ -724,8 +740,8 @@ void InputSimulator::setRumble(float leftMotor, float rightMotor) const
 	leftMotor  = std::clamp(leftMotor, 0.0f, 1.0f);
 	rightMotor = std::clamp(rightMotor, 0.0f, 1.0f);
 
-	parent->output.leftMotor  = std::max(static_cast<uint8_t>(leftMotor * 255.0f),  parent->output.leftMotor);
-	parent->output.rightMotor = std::max(static_cast<uint8_t>(rightMotor * 255.0f), parent->output.rightMotor);
+	output.leftMotor  = std::max(static_cast<uint8_t>(leftMotor * 255.0f),  output.leftMotor);
+	output.rightMotor = std::max(static_cast<uint8_t>(rightMotor * 255.0f), output.rightMotor);
 }
 
 bool InputSimulator::addSimulator(ISimulator* simulator)
@@ -771,6 +787,7 @@ void InputSimulator::runSimulators()
 	{
 		ISimulator* ptr = *it;
 		ptr->update(deltaTime);
+		ptr->lastUpdate.start();
 
 		if (ptr->state == SimulatorState::inactive)
 		{
@@ -788,18 +805,27 @@ void InputSimulator::runMaps()
 {
 	startTick();
 
+	fullUpdate = fullUpdatePending;
+	fullUpdatePending = false;
+
+	// only here, since pressed buttons are only new once per report
+	if (!activeProfile->plan.triggers.empty())
+	{
+		activeProfile->plan.triggers.update(input.heldButtons, input.pressedButtons, TickClock::now());
+	}
+
 	updateTouchRegions();
 	updateModifierStates();
 	updateBindingStates();
 
 	runSimulators();
 
-	if (parent->profile.useXInput &&
-	    xinputTarget && xinputTarget->connected() &&
+	if (activeProfile->profile.useXInput &&
+	    sinks.virtualPad != nullptr && sinks.virtualPad->connected() &&
 	    xinputPad != xinputLast)
 	{
 		xinputLast = xinputPad;
-		xinputTarget->update(xinputPad);
+		sinks.virtualPad->update(xinputPad);
 	}
 }
 
@@ -807,65 +833,167 @@ void InputSimulator::runPersistent()
 {
 	startTick();
 
-	for (InputModifier* modifier : modifiers.allMaps())
+	for (const ModifierPlanOp& op : activeProfile->plan.modifiers)
 	{
-		if (modifier->isPersistent())
+		if (op.modifier->isPersistent())
 		{
-			updateModifierState(*modifier);
+			updateModifierState(op);
 		}
 	}
 
-	for (InputMap* map : bindings.allMaps())
+	for (const BindingPlanOp& op : activeProfile->plan.bindings)
 	{
-		if (map->isPersistent())
+		if (op.map->isPersistent())
 		{
-			updateBindingState(*map, nullptr);
+			updateBindingState(op);
 		}
 	}
 
 	runSimulators();
 }
 
+std::optional<Stopwatch::Duration> InputSimulator::timeUntilUpdate() const
+{
+	// a published profile is applied by the next tick, so don't wait for input to get one
+	if (pendingProfile.load(std::memory_order_relaxed) != nullptr)
+	{
+		return Stopwatch::Duration::zero();
+	}
+
+	std::optional<Stopwatch::Duration> result;
+
+	auto earliest = [&](const std::optional<Stopwatch::Duration>& value)
+	{
+		if (value.has_value() && (!result.has_value() || *value < *result))
+		{
+			result = value;
+		}
+	};
+
+	for (const ModifierPlanOp& op : activeProfile->plan.modifiers)
+	{
+		earliest(op.modifier->timeUntilUpdate());
+	}
+
+	for (const BindingPlanOp& op : activeProfile->plan.bindings)
+	{
+		earliest(op.map->timeUntilUpdate());
+	}
+
+	for (const ISimulator* simulator : simulators)
+	{
+		earliest(simulator->timeUntilUpdate());
+	}
+
+	return result;
+}
+
 void InputSimulator::updateTouchRegions()
 {
-	Ds4Buttons_t disallow = 0;
+	const std::vector<Ds4TouchRegion*>& regions = activeProfile->touchRegionsById;
+
+	const Ds4Vector2& point1 = input.data.touchPoint1;
+	const Ds4Vector2& point2 = input.data.touchPoint2;
 
-	std::ranges::sort(sortableTouchRegions, [](const Ds4TouchRegion* a, const Ds4TouchRegion* b)
+	const Ds4Buttons_t heldTouchPoints     = input.heldButtons & touchMask;
+	const Ds4Buttons_t inactiveTouchPoints = heldTouchPoints ^ touchMask;
+
+	// every region reads its touch points from here, so each report is recorded once
+	touchHistory_.record(TickClock::now(), input.data.frameCount, point1, point2);
+	touchGestures_.update(touchHistory_, heldTouchPoints);
+
+	// only regions which are live or under a held touch point can change state this tick
+	std::ranges::copy(liveTouchRegions, visitedTouchRegions.begin());
+
+	if (heldTouchPoints & Ds4Buttons::touch1)
 	{
-		return (a->isTouchActive(touchMask) && !a->allowCrossOver) && !(b->isTouchActive(touchMask) && !b->allowCrossOver);
-	});
+		activeProfile->touchRegionGrid.addCandidates(point1, visitedTouchRegions);
+	}
 
-	const Ds4Buttons_t inactiveTouchPoints = (parent->input.heldButtons & touchMask) ^ touchMask;
+	if (heldTouchPoints & Ds4Buttons::touch2)
+	{
+		activeProfile->touchRegionGrid.addCandidates(point2, visitedTouchRegions);
+	}
+
+	Ds4Buttons_t disallow = 0;
+	bool unsettled = false;
 
-	auto makeInactive = [&](Ds4Buttons_t touchId, Ds4TouchRegion* region, const Ds4Vector2& point)
+	auto makeInactive = [&](Ds4Buttons_t touchId, Ds4TouchRegion* region)
 	{
 		if ((inactiveTouchPoints & touchId) && region->isTouchActive(touchId))
 		{
-			region->deactivateTouch(touchId, point);
+			region->deactivateTouch(touchId);
 		}
 	};
 
 	// TODO: devise a cleaner way to get and manipulate touch data for each touch point
 
-	for (auto& region : sortableTouchRegions)
+	auto update = [&](size_t id)
 	{
+		Ds4TouchRegion* region = regions[id];
+
 		if (region->isTouchActive(inactiveTouchPoints))
 		{
-			makeInactive(Ds4Buttons::touch1, region, parent->input.data.touchPoint1);
-			makeInactive(Ds4Buttons::touch2, region, parent->input.data.touchPoint2);
-			continue;
+			makeInactive(Ds4Buttons::touch1, region);
+			makeInactive(Ds4Buttons::touch2, region);
+		}
+		else
+		{
+			updateTouchRegion(*region, Ds4Buttons::touch1, point1, disallow);
+			updateTouchRegion(*region, Ds4Buttons::touch2, point2, disallow);
+		}
+
+		const bool regionUnsettled = !isSettled(region->state1.pressedState) || !isSettled(region->state2.pressedState);
+		const uint64_t bit = 1ull << (id % 64);
+
+		if (regionUnsettled || region->isTouchActive(touchMask))
+		{
+			liveTouchRegions[id / 64] |= bit;
+		}
+		else
+		{
+			liveTouchRegions[id / 64] &= ~bit;
+		}
+
+		unsettled = unsettled || regionUnsettled;
+	};
+
+	// regions which hold a touch point without allowing cross-over go first, so that they keep it
+	for (size_t w = 0; w < visitedTouchRegions.size(); ++w)
+	{
+		for (uint64_t visited = visitedTouchRegions[w]; visited != 0; visited &= visited - 1)
+		{
+			const size_t id = w * 64 + std::countr_zero(visited);
+			const Ds4TouchRegion* region = regions[id];
+
+			if (region->isTouchActive(touchMask) && !region->allowCrossOver)
+			{
+				update(id);
+				visitedTouchRegions[w] &= ~(1ull << (id % 64));
+			}
 		}
+	}
 
-		updateTouchRegion(*region, Ds4Buttons::touch1, parent->input.data.touchPoint1, disallow);
-		updateTouchRegion(*region, Ds4Buttons::touch2, parent->input.data.touchPoint2, disallow);
+	for (size_t w = 0; w < visitedTouchRegions.size(); ++w)
+	{
+		for (uint64_t visited = visitedTouchRegions[w]; visited != 0; visited &= visited - 1)
+		{
+			update(w * 64 + std::countr_zero(visited));
+		}
 	}
+
+	const Ds4Buttons_t changedButtons = input.pressedButtons | input.releasedButtons;
+
+	// regions which were unsettled last tick may have settled since, which their bindings must observe
+	touchDirty = input.touchChanged || !!(changedButtons & touchMask) || unsettled || touchUnsettled;
+	touchUnsettled = unsettled;
 }
 
 void InputSimulator::updateTouchRegion(Ds4TouchRegion& region, Ds4Buttons_t sender, const Ds4Vector2& point, Ds4Buttons_t& disallow) const
 {
-	if (!!(disallow & sender) || !(parent->input.heldButtons & sender) || !region.isInRegion(sender, point))
+	if (!!(disallow & sender) || !(input.heldButtons & sender) || !region.isInRegion(sender, point))
 	{
-		region.deactivateTouch(sender, point);
+		region.deactivateTouch(sender);
 		return;
 	}
 
@@ -877,9 +1005,11 @@ void InputSimulator::updateTouchRegion(Ds4TouchRegion& region, Ds4Buttons_t send
 	}
 }
 
-void InputSimulator::updatePressedState(InputMapBase& instance, const std::function<void()>& press, const std::function<void()>& release)
+template <typename Press, typename Release>
+void InputSimulator::updatePressedState(InputMapBase& instance, const BindingPlanSource& source,
+                                        bool modifierBinding, Press&& press, Release&& release)
 {
-	if (isOverriddenByModifierSet(instance))
+	if (isOverriddenByModifierSet(instance, source, modifierBinding))
 	{
 		release();
 		return;
@@ -887,7 +1017,7 @@ void InputSimulator::updatePressedState(InputMapBase& instance, const std::funct
 
 	for (InputType_t value : InputType_values)
 	{
-		if ((instance.inputType & value) == 0)
+		if ((source.inputType & value) == 0)
 		{
 			continue;
 		}
@@ -895,7 +1025,7 @@ void InputSimulator::updatePressedState(InputMapBase& instance, const std::funct
 		switch (value)
 		{
 			case InputType::button:
-				if ((instance.inputButtons.value() & parent->input.heldButtons) == instance.inputButtons)
+				if ((source.buttons & input.heldButtons) == source.buttons)
 				{
 					press();
 				}
@@ -908,42 +1038,20 @@ void InputSimulator::updatePressedState(InputMapBase& instance, const std::funct
 
 			case InputType::axis:
 			{
-				if (instance.inputAxes.value_or(0) == 0)
+				if (source.axes == 0)
 				{
 					throw std::invalid_argument("inputAxes has invalid or no value");
 				}
 
-				const std::span<const Ds4Axes_t> axes(Ds4Axes_values);
+				const auto& values = input.getAllAxes();
 
-				const size_t target = std::ranges::count_if(axes, [&](Ds4Axes_t x) -> bool
+				const bool allPastDeadZone = std::ranges::all_of(activeProfile->plan.getAxes(source), [&](const BindingPlanAxis& axis) -> bool
 				{
-					return (x & instance.inputAxes.value()) != 0;
+					const float value = Ds4Input::applyPolarity(values[axis.index], axis.options.polarity);
+					return value >= axis.options.deadZone.value_or(0.0f);
 				});
 
-				size_t count = 0;
-
-				for (Ds4Axes_t bit : Ds4Axes_values)
-				{
-					if (!(instance.inputAxes.value() & bit))
-					{
-						continue;
-					}
-
-					InputAxisOptions options = instance.getAxisOptions(bit);
-
-					const float axis = parent->input.getAxis(instance.inputAxes.value(), options.polarity);
-
-					if (axis >= options.deadZone.value_or(0.0f))
-					{
-						++count;
-					}
-					else
-					{
-						break;
-					}
-				}
-
-				if (count == target)
+				if (allPastDeadZone)
 				{
 					press();
 				}
@@ -957,15 +1065,14 @@ void InputSimulator::updatePressedState(InputMapBase& instance, const std::funct
 
 			case InputType::touchRegion:
 			{
-				auto it = touchRegions.find(instance.inputTouchRegion);
+				Ds4TouchRegion* region = source.touchRegion;
 
-				if (it == touchRegions.end())
+				if (region == nullptr)
 				{
 					break;
 				}
 
-				Ds4TouchRegion* region = it->second;
-				const auto direction = instance.inputTouchDirection.value_or(Direction::none);
+				const Direction_t direction = source.touchDirection;
 
 				if (region->isActive(Ds4Buttons::touch1, direction) ||
 				    region->isActive(Ds4Buttons::touch2, direction))
@@ -980,6 +1087,18 @@ void InputSimulator::updatePressedState(InputMapBase& instance, const std::funct
 				break;
 			}
 
+			case InputType::trigger:
+				if (source.triggerButtons != 0 && activeProfile->plan.triggers.isActive(source.triggerId))
+				{
+					press();
+				}
+				else
+				{
+					release();
+				}
+
+				break;
+
 			case InputType::none:
 				break;
 
@@ -989,155 +1108,62 @@ void InputSimulator::updatePressedState(InputMapBase& instance, const std::funct
 	}
 }
 
-bool InputSimulator::updateModifierState(InputModifier& modifier)
+bool InputSimulator::updateModifierState(const ModifierPlanOp& op)
 {
+	InputModifier& modifier = *op.modifier;
 	const PressedState oldPressedState = modifier.pressedState;
 
-	const auto press = [&]() -> void
-	{
-		modifier.press();
-	};
+	updatePressedState(modifier, op.source, false,
+	                   [&] { modifier.press(); },
+	                   [&] { modifier.release(); });
 
-	const auto release = [&]() -> void
+	for (const BindingPlanOp& bindingOp : activeProfile->plan.getBindings(op))
 	{
-		modifier.release();
-	};
+		const bool wasActive = bindingOp.map->isActive();
 
-	updatePressedState(modifier, press, release);
+		updateBindingState(bindingOp);
 
-	if (!modifier.bindings.empty())
-	{
-		for (InputMap& bind : modifier.bindings)
+		if (bindingOp.map->isActive() != wasActive)
 		{
-			updateBindingState(bind, &modifier);
+			// this binding may now override (or stop overriding) others which share its inputs
+			fullUpdate        = true;
+			fullUpdatePending = true;
+			suppressionDirty  = true;
 		}
 	}
 
 	return oldPressedState != modifier.pressedState;
 }
 
-bool InputSimulator::updateBindingState(InputMap& map, InputModifier* modifier)
+bool InputSimulator::updateBindingState(const BindingPlanOp& op)
 {
+	InputMap& map = *op.map;
+	InputModifier* modifier = op.modifier;
 	const PressedState oldPressedState = map.pressedState;
 
 	if (modifier != nullptr && map.toggle != true && !modifier->isActive())
 	{
 		map.release();
-		runMap(map, modifier);
+		runMap(op);
 		return map.pressedState != oldPressedState;
 	}
 
-	const auto press = [&]() -> void
-	{
-		map.pressWithModifier(modifier);
-	};
-
-	const auto release = [&]() -> void
-	{
-		map.release();
-	};
-
-	updatePressedState(map, press, release);
-	runMap(map, modifier);
+	updatePressedState(map, op.source, modifier != nullptr,
+	                   [&] { map.pressWithModifier(modifier); },
+	                   [&] { map.release(); });
+	runMap(op);
 	return oldPressedState != map.pressedState;
 }
 
 bool InputSimulator::xinputConnect()
 {
-	if (!xinputTargetOpen())
-	{
-		return false;
-	}
-
-	if (xinputTarget->connected())
-	{
-		return true;
-	}
-
-	VIGEM_ERROR vigemResult = xinputTarget->connect();
-
-	if (VIGEM_SUCCESS(vigemResult))
-	{
-		return true;
-	}
-
-	// If connecting an emulated XInput controller failed,
-	// it's likely because it's already connected. Disconnect
-	// it before continuing.
-	vigemResult = xinputTarget->disconnect();
-
-	if (!VIGEM_SUCCESS(vigemResult))
-	{
-		// TODO: implement a callback for ViGEm target disconnect failure
-		Logger::writeLine(LogLevel::warning, parent->name(), "ViGEm target connect followed by disconnect failed: " + std::to_string(vigemResult));
-	}
-
-	// Attempt to recover the virtual controller up to 4 times on a 250ms interval.
-	for (size_t i = 0; i < 4; i++)
-	{
-		vigemResult = xinputTarget->connect();
-
-		if (VIGEM_SUCCESS(vigemResult))
-		{
-			break;
-		}
-
-		std::this_thread::yield();
-		std::this_thread::sleep_for(250ms);
-	}
-
-	if (!VIGEM_SUCCESS(vigemResult))
-	{
-		// TODO: implement a callback for ViGEm target connect failure
-		Logger::writeLine(LogLevel::warning, parent->name(), "ViGEm target connect failed: " + std::to_string(vigemResult));
-		return false;
-	}
-
-	return true;
+	return sinks.virtualPad != nullptr && sinks.virtualPad->connect();
 }
 
 void InputSimulator::xinputDisconnect()
 {
-	if (!xinputTarget)
-	{
-		return;
-	}
-
-	const VIGEM_ERROR result = xinputTarget->disconnect();
-
-	if (!VIGEM_SUCCESS(result))
-	{
-		// TODO: implement a callback for ViGEm target disconnect failure
-		Logger::writeLine(LogLevel::warning, parent->name(), "ViGEm target disconnect failed: " + std::to_string(result));
-	}
-}
-
-bool InputSimulator::xinputTargetOpen()
-{
-	if (!Program::driver.isOpen())
-	{
-		return false;
-	}
-
-	if (xinputTarget == nullptr)
-	{
-		xinputTarget = std::make_shared<vigem::XInputTarget>(&Program::driver);
-
-		xinputRumbleSimulator = std::make_unique<XInputRumbleSimulator>(this);
-		xinputRumbleSimulator->xinputTarget = xinputTarget;
-	}
-
-	return true;
-}
-
-void InputSimulator::xinputTargetClose()
-{
-	if (xinputRumbleSimulator)
+	if (sinks.virtualPad != nullptr)
 	{
-		removeSimulator(xinputRumbleSimulator.get());
-		xinputRumbleSimulator = nullptr;
+		sinks.virtualPad->disconnect();
 	}
-
-	xinputDisconnect();
-	xinputTarget = nullptr;
 }
@@ -1,23 +1,25 @@
 #pragma once
 
-#include <functional>
+#include <atomic>
+#include <memory>
 #include <unordered_set>
 #include <unordered_map>
 
-#include "KeyboardSimulator.h"
-#include "MouseSimulator.h"
 #include "enums.h"
 #include "Pressable.h"
 #include "InputMap.h"
+#include "InputSinks.h"
 #include "XInputGamepad.h"
-#include "ViGEmTarget.h"
-#include "MapCache.h"
+#include "BindingPlan.h"
+#include "CompiledProfile.h"
+#include "Ds4Input.h"
+#include "Ds4Output.h"
+#include "Ds4TouchGestures.h"
+#include "Ds4TouchHistory.h"
 #include "ISimulator.h"
 #include "XInputRumbleSimulator.h"
 #include "RumbleSequence.h"
 
-class Ds4Device;
-
 /**
  * \brief Class for handling input maps and outputting simulated inputs to simulated input devices (keyboard, mouse, XInput, etc)
  */
@@ -25,21 +27,73 @@ class InputSimulator
 {
 	static constexpr Ds4Buttons_t touchMask = Ds4Buttons::touch1 | Ds4Buttons::touch2;
 
-	Ds4Device* parent = nullptr;
+	const Ds4Input& input;
+	Ds4Output& output;
+	InputSimulatorSinks sinks;
+
+	/**
+	 * \brief The profile being simulated. Only used by the device thread.
+	 */
+	std::unique_ptr<CompiledProfile> activeProfile;
+
+	/**
+	 * \brief A profile published by another thread, to be applied at the start of the next tick.
+	 * \sa publishProfile
+	 */
+	std::atomic<CompiledProfile*> pendingProfile { nullptr };
+
+	/**
+	 * \brief The last profile replaced by \c activeProfile, kept alive so that it is destroyed
+	 * by the next call to \c publishProfile rather than by the device thread.
+	 */
+	std::atomic<CompiledProfile*> retiredProfile { nullptr };
+
+	/**
+	 * \brief Inputs claimed by active modifier bindings. Only rebuilt when a modifier binding
+	 * changes active state. \sa isOverriddenByModifierSet
+	 */
+	BindingPlanSuppression suppression;
+	bool suppressionDirty = true;
 
-	KeyboardSimulator keyboard;
-	MouseSimulator mouse;
+	/**
+	 * \brief Plan ops whose pressed state had not settled as of the last tick,
+	 * which must be evaluated again even if their inputs do not change.
+	 */
+	BindingPlanOpSet pendingModifiers;
+	BindingPlanOpSet pendingBindings;
 
-	Ds4TouchRegionCache touchRegions;
-	std::vector<Ds4TouchRegion*> sortableTouchRegions;
+	/**
+	 * \brief Plan ops to be evaluated this tick. Reused between ticks to avoid allocation.
+	 */
+	BindingPlanOpSet dirtyOps;
 
-	std::unordered_map<InputModifier*, MapCacheCollection<InputMap>> modifierMaps;
-	MapCacheCollection<InputModifier> modifiers;
-	MapCacheCollection<InputMap> bindings;
+	/**
+	 * \brief When set, every op in the plan is evaluated regardless of input changes.
+	 * This is the case after a profile is applied and whenever a modifier binding changes
+	 * active state, since that changes which bindings it overrides.
+	 */
+	bool fullUpdate = true;
+	bool fullUpdatePending = true;
+
+	/**
+	 * \brief Indicates if touch regions may have changed state this tick.
+	 */
+	bool touchDirty = false;
+	bool touchUnsettled = false;
+
+	/**
+	 * \brief Bitset of touch regions, by ID, which are active or whose pressed state has not settled.
+	 * Every other region is idle, and can only be affected by a touch point within its bounds.
+	 */
+	std::vector<uint64_t> liveTouchRegions;
+
+	/**
+	 * \brief Bitset of touch regions to be updated this tick. Reused between ticks to avoid allocation.
+	 */
+	std::vector<uint64_t> visitedTouchRegions;
 
 	XInputGamepad xinputPad {};
 	XInputGamepad xinputLast {};
-	std::shared_ptr<vigem::XInputTarget> xinputTarget;
 	XInputAxis_t simulatedXInputAxis = 0;
 
 	// TODO: refactor delta time to be the elapsed time of the last tick in seconds
@@ -51,6 +105,11 @@ class InputSimulator
 	std::unordered_set<ISimulator*> simulators;
 	std::unique_ptr<RumbleSequence> rumbleSequence;
 
+	bool headless_ = false;
+
+	Ds4TouchHistory touchHistory_;
+	Ds4TouchGestures touchGestures_;
+
 public:
 	/** \brief \c InputSimulator cannot be copied or moved. */
 	InputSimulator() = delete;
@@ -63,7 +122,12 @@ public:
 	/** \brief \c InputSimulator cannot be copied or moved. */
 	InputSimulator& operator=(InputSimulator&&) = delete;
 
-	explicit InputSimulator(Ds4Device* parent);
+	/**
+	 * \param input The input of the device being simulated, read each tick.
+	 * \param output The output of the device being simulated, to which rumble is written each tick.
+	 * \param sinks Where simulated output is sent. Each sink must outlive the simulator.
+	 */
+	InputSimulator(const Ds4Input& input, Ds4Output& output, const InputSimulatorSinks& sinks);
 	~InputSimulator();
 
 	/**
@@ -71,6 +135,30 @@ public:
 	 */
 	void start();
 
+	/**
+	 * \brief Enables or disables headless simulation. While headless, keyboard, mouse and XInput
+	 * state is fully simulated but never sent to any of the simulator's sinks.
+	 * \sa xinputState
+	 */
+	void setHeadless(bool headless);
+
+	[[nodiscard]] bool headless() const;
+
+	/**
+	 * \brief The simulated XInput state as of the last tick.
+	 */
+	[[nodiscard]] const XInputGamepad& xinputState() const;
+
+	/**
+	 * \brief The recent touch points of the device, shared by every touch region of the active profile.
+	 */
+	[[nodiscard]] const Ds4TouchHistory& touchHistory() const;
+
+	/**
+	 * \brief The motion of the device's touch points, shared by every gesture touch region of the active profile.
+	 */
+	[[nodiscard]] const Ds4TouchGestures& touchGestures() const;
+
 private:
 	/**
 	 * \brief Simulates XInput buttons.
@@ -89,9 +177,16 @@ private:
 	/**
 	 * \brief Checks if the given input map is overridden by an input map from the currently-active modifier set.
 	 * \param map The map whose overridden state is to be checked.
+	 * \param source The compiled input sources of \p map.
+	 * \param modifierBinding \c true if \p map is itself the binding of a modifier set.
 	 * \return \c true if overridden by a modifier.
 	 */
-	bool isOverriddenByModifierSet(const InputMapBase& map);
+	bool isOverriddenByModifierSet(const InputMapBase& map, const BindingPlanSource& source, bool modifierBinding);
+
+	/**
+	 * \brief Rebuilds \c suppression from the current state of every modifier binding.
+	 */
+	void updateSuppression();
 
 	/**
 	 * \brief Given an axis, get the associated stick vector if applicable, and apply axis options.
@@ -102,18 +197,26 @@ private:
 	[[nodiscard]] float getAxisWithOptionsApplied(Ds4Axes_t axes, const InputAxisOptions& options) const;
 
 	/**
-	 * \brief Runs an input map with an optional parent modifier.
-	 * \param m The map to run.
-	 * \param modifier The parent modifier, if any.
+	 * \brief Runs an input map with its parent modifier, if any.
+	 * \param op The compiled map to run.
 	 */
-	void runMap(const InputMap& m, InputModifier const* modifier);
+	void runMap(const BindingPlanOp& op);
 
 public:
 	/**
-	 * \brief Applies a profile to the device.
+	 * \brief Applies a compiled profile immediately. Must be called from the thread running
+	 * the simulator, or while the simulator is not running.
 	 * \param profile The profile to apply.
 	 */
-	void applyProfile(DeviceProfile* profile);
+	void applyProfile(std::unique_ptr<CompiledProfile> profile);
+
+	/**
+	 * \brief Hands a compiled profile to the simulator to be applied at the start of its next tick.
+	 * Safe to call from any thread, and never waits on the simulator. A profile published
+	 * before the previous one was applied replaces it.
+	 * \param profile The profile to apply.
+	 */
+	void publishProfile(std::unique_ptr<CompiledProfile> profile);
 
 private:
 	/**
@@ -155,20 +258,48 @@ private:
 	 */
 	void runAction(ActionType action) const;
 
+	/**
+	 * \brief The keyboard sink, or \c nullptr if there is none or the simulator is headless.
+	 */
+	[[nodiscard]] IKeyboardSink* keyboardSink() const;
+
+	/**
+	 * \brief The mouse sink, or \c nullptr if there is none or the simulator is headless.
+	 */
+	[[nodiscard]] IMouseSink* mouseSink() const;
+
 	/**
 	 * \brief Updates the delta time scale. Called by \sa startTick
 	 */
 	void updateDeltaTime();
 
 	/**
-	 * \brief Updates the pressed states of all the managed modifier sets.
+	 * \brief Updates the pressed states of the managed modifier sets affected by input changes.
 	 */
 	void updateModifierStates();
 
 	/**
-	 * \brief Updates the pressed states of all managed bindings.
+	 * \brief Updates the pressed states of the managed bindings affected by input changes.
 	 */
 	void updateBindingStates();
+
+	/**
+	 * \brief Fills \c dirtyOps with the ops of an index that must be evaluated this tick.
+	 * \param index The index of the ops.
+	 * \param count The total number of ops in the index, used when \c fullUpdate is set.
+	 * \param pending Ops which had not settled as of the last tick.
+	 */
+	void collectDirtyOps(const BindingPlanIndex& index, size_t count, const BindingPlanOpSet& pending);
+
+	/**
+	 * \brief Indicates if a pressed state will remain the same when its input does not change.
+	 */
+	static bool isSettled(PressedState state);
+
+	/**
+	 * \brief Indicates if the pressed and simulated states of a map will remain the same when its input does not change.
+	 */
+	static bool isSettled(const InputMapBase& map);
 	
 	/**
 	 * \brief
@@ -216,6 +347,13 @@ public:
 	 */
 	void runPersistent();
 
+	/**
+	 * \brief Gets the time remaining until a persistent input map or tracked simulator
+	 * needs to be updated without new input, or \c std::nullopt if nothing is scheduled.
+	 * \sa runPersistent
+	 */
+	[[nodiscard]] std::optional<Stopwatch::Duration> timeUntilUpdate() const;
+
 private:
 	/**
 	 * \brief Runs all touch regions managed by this instance.
@@ -236,17 +374,23 @@ private:
 	/**
 	 * \brief Internal implementation of \sa updatePressedState
 	 * \param instance Input map whose state is to be updated.
+	 * \param source The compiled input sources of \p instance.
+	 * \param modifierBinding \c true if \p instance is the binding of a modifier set.
 	 * \param press Press callback.
 	 * \param release Release callback.
+	 * \remarks The callbacks are template parameters rather than type-erased so that they
+	 * can be inlined into the evaluation of each input type. Only instantiated by \c InputSimulator.cpp.
 	 */
-	void updatePressedState(InputMapBase& instance, const std::function<void()>& press, const std::function<void()>& release);
+	template <typename Press, typename Release>
+	void updatePressedState(InputMapBase& instance, const BindingPlanSource& source, bool modifierBinding,
+	                        Press&& press, Release&& release);
 
 	/**
 	 * \brief Updates the pressed state of a modifier set and its managed child bindings.
-	 * \param modifier The modifier to update.
+	 * \param op The compiled modifier to update.
 	 * \return \c true if the active state of the modifier has changed.
 	 */
-	bool updateModifierState(InputModifier& modifier);
+	bool updateModifierState(const ModifierPlanOp& op);
 
 	/**
 	 * \brief
@@ -255,32 +399,20 @@ private:
 	 * If provided, the parent \p modifier must be active for \p map to be activated.
 	 * Otherwise, the map's pressed state is made inactive.
 	 * 
-	 * \param map The map to update.
-	 * \param modifier The parent modifier set, if any.
+	 * \param op The compiled map to update, including its parent modifier set, if any.
 	 *
 	 * \return \c true if the pressed state of the map has changed.
 	 */
-	bool updateBindingState(InputMap& map, InputModifier* modifier);
+	bool updateBindingState(const BindingPlanOp& op);
 
 	/**
-	 * \brief Connects a virtual XInput device to the system.
+	 * \brief Connects the virtual XInput pad, if any.
 	 * \return \c true on success.
 	 */
 	bool xinputConnect();
 
 	/**
-	 * \brief Disconnects a virtual XInput device from the system.
+	 * \brief Disconnects the virtual XInput pad, if any.
 	 */
 	void xinputDisconnect();
-
-	/**
-	 * \brief Acquires a handle to the XInput emulation driver.
-	 * \return \c true on success.
-	 */
-	bool xinputTargetOpen();
-
-	/**
-	 * \brief Closes the handle to the XInput emulation driver.
-	 */
-	void xinputTargetClose();
 };
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstdint>
+
+#include "enums.h"
+#include "XInputGamepad.h"
+
+/**
+ * \brief Receives simulated keyboard input. \sa KeyboardSimulator
+ */
+class IKeyboardSink
+{
+public:
+	virtual ~IKeyboardSink() = default;
+
+	/**
+	 * \brief Presses a key specified by \a keyCode.
+	 * \param keyCode The key code to press.
+	 */
+	virtual void keyDown(int keyCode) = 0;
+
+	/**
+	 * \brief Releases a key specified by \a keyCode.
+	 * \param keyCode The key code to release.
+	 */
+	virtual void keyUp(int keyCode) = 0;
+};
+
+/**
+ * \brief Receives simulated mouse input. \sa MouseSimulator
+ */
+class IMouseSink
+{
+public:
+	virtual ~IMouseSink() = default;
+
+	/**
+	 * \brief Presses a mouse button.
+	 * \param button The button to press.
+	 */
+	virtual void buttonDown(MouseButton button) = 0;
+
+	/**
+	 * \brief Releases a mouse button.
+	 * \param button The button to release.
+	 */
+	virtual void buttonUp(MouseButton button) = 0;
+
+	/**
+	 * \brief Moves the cursor relative to its current position.
+	 * \param dx X delta to move by, in pixels.
+	 * \param dy Y delta to move by, in pixels.
+	 */
+	virtual void moveBy(int dx, int dy) = 0;
+};
+
+/**
+ * \brief Motor speeds requested of a virtual pad by whatever is reading it.
+ */
+struct XInputVibration
+{
+	uint8_t leftMotor  = 0;
+	uint8_t rightMotor = 0;
+};
+
+/**
+ * \brief A virtual XInput pad which receives simulated XInput state. \sa VirtualXInputPad
+ */
+class IVirtualPadSink
+{
+public:
+	virtual ~IVirtualPadSink() = default;
+
+	/**
+	 * \brief Connects the virtual pad to the system if it isn't already.
+	 * \return \c true if the pad is connected.
+	 */
+	virtual bool connect() = 0;
+
+	/**
+	 * \brief Disconnects the virtual pad from the system if it is connected.
+	 */
+	virtual void disconnect() = 0;
+
+	[[nodiscard]] virtual bool connected() const = 0;
+
+	/**
+	 * \brief Sends new state to the virtual pad. Only called when the state has changed.
+	 * \param state The state to send.
+	 */
+	virtual void update(const XInputGamepad& state) = 0;
+
+	/**
+	 * \brief The motor speeds most recently requested of the virtual pad.
+	 * May change at any time, so it is polled. \sa XInputRumbleSimulator
+	 */
+	[[nodiscard]] virtual XInputVibration vibration() const = 0;
+};
+
+/**
+ * \brief Performs special actions on behalf of an input map, such as disconnecting the device. \sa Ds4Device
+ */
+class IDeviceActionSink
+{
+public:
+	virtual ~IDeviceActionSink() = default;
+
+	/**
+	 * \brief Performs \p action.
+	 * \param action The action to perform.
+	 */
+	virtual void runAction(ActionType action) = 0;
+};
+
+/**
+ * \brief Everything an \c InputSimulator sends simulated output to.
+ * Output for a sink which is \c nullptr is simulated but discarded.
+ */
+struct InputSimulatorSinks
+{
+	IKeyboardSink*     keyboard   = nullptr;
+	IMouseSink*        mouse      = nullptr;
+	IVirtualPadSink*   virtualPad = nullptr;
+	IDeviceActionSink* actions    = nullptr;
+};
@@ -0,0 +1,379 @@
+#include "pch.h"
+
+#include <algorithm>
+#include <bit>
+
+#include "InputTrigger.h"
+
+namespace
+{
+	void setBit(std::vector<uint64_t>& words, size_t bit)
+	{
+		words[bit / 64] |= 1ull << (bit % 64);
+	}
+}
+
+Ds4Buttons_t InputTrigger::buttons() const
+{
+	Ds4Buttons_t result = 0;
+
+	for (const Ds4Buttons_t step : steps)
+	{
+		result |= step;
+	}
+
+	return result;
+}
+
+bool InputTrigger::isValid() const
+{
+	if (steps.empty() || window.count() < 0 || std::ranges::find(steps, 0u) != steps.end())
+	{
+		return false;
+	}
+
+	switch (type)
+	{
+		case InputTriggerType::chord:
+		case InputTriggerType::hold:
+			return steps.size() == 1;
+
+		case InputTriggerType::tap:
+			return steps.size() == 1 && window.count() > 0;
+
+		case InputTriggerType::sequence:
+			return steps.size() <= maxSequenceLength && window.count() > 0;
+
+		default:
+			return false;
+	}
+}
+
+bool InputTrigger::operator==(const InputTrigger& other) const
+{
+	return type == other.type
+	       && steps == other.steps
+	       && window == other.window;
+}
+
+bool InputTrigger::operator!=(const InputTrigger& other) const
+{
+	return !(*this == other);
+}
+
+void InputTrigger::readJson(const nlohmann::json& json)
+{
+	if (json.find("type") != json.end())
+	{
+		type = InputTriggerType::_from_string(json["type"].get<std::string>().c_str());
+	}
+
+	if (json.find("steps") != json.end())
+	{
+		steps.clear();
+
+		for (const auto& step : json["steps"])
+		{
+			Ds4Buttons_t buttons;
+			ENUM_DESERIALIZE_FLAGS(Ds4Buttons)(step.get<std::string>(), buttons);
+			steps.push_back(buttons);
+		}
+	}
+
+	if (json.find("window") != json.end())
+	{
+		window = std::chrono::milliseconds(json["window"].get<int64_t>());
+	}
+}
+
+void InputTrigger::writeJson(nlohmann::json& json) const
+{
+	json["type"] = type._to_string();
+
+	nlohmann::json steps_ = nlohmann::json::array();
+
+	for (const Ds4Buttons_t step : steps)
+	{
+		steps_.push_back(ENUM_SERIALIZE_FLAGS(Ds4Buttons)(step));
+	}
+
+	json["steps"]  = steps_;
+	json["window"] = window.count();
+}
+
+std::optional<uint32_t> InputTriggerEngine::add(const InputTrigger& trigger)
+{
+	if (!trigger.isValid())
+	{
+		return std::nullopt;
+	}
+
+	const auto id = static_cast<uint32_t>(triggers.size());
+
+	TriggerState state;
+	state.type   = trigger.type;
+	state.window = trigger.window;
+
+	if (trigger.type == +InputTriggerType::sequence)
+	{
+		state.buttons = trigger.steps.back();
+		state.length  = static_cast<uint32_t>(trigger.steps.size());
+
+		const size_t first = sequenceBits;
+		sequenceBits += state.length;
+
+		const size_t words = (sequenceBits + 63) / 64;
+
+		sequenceState.resize(words);
+		sequenceStart.resize(words);
+		sequenceAccept.resize(words);
+
+		for (auto& symbols : sequenceSymbols)
+		{
+			symbols.resize(words);
+		}
+
+		sequenceTriggers.resize(sequenceBits);
+
+		setBit(sequenceStart, first);
+		setBit(sequenceAccept, sequenceBits - 1);
+		sequenceTriggers[sequenceBits - 1] = id;
+
+		for (size_t step = 0; step < trigger.steps.size(); ++step)
+		{
+			for (size_t i = 0; i < buttonCount; ++i)
+			{
+				if (trigger.steps[step] & Ds4Buttons_values[i])
+				{
+					setBit(sequenceSymbols[i], first + step);
+				}
+			}
+		}
+	}
+	else
+	{
+		state.buttons = trigger.steps.front();
+
+		for (size_t i = 0; i < buttonCount; ++i)
+		{
+			if (state.buttons & Ds4Buttons_values[i])
+			{
+				triggersByButton[i].push_back(id);
+			}
+		}
+	}
+
+	triggers.push_back(state);
+	return id;
+}
+
+void InputTriggerEngine::clear()
+{
+	triggers.clear();
+	pending.clear();
+
+	for (auto& ids : triggersByButton)
+	{
+		ids.clear();
+	}
+
+	sequenceState.clear();
+	sequenceStart.clear();
+	sequenceAccept.clear();
+
+	for (auto& symbols : sequenceSymbols)
+	{
+		symbols.clear();
+	}
+
+	sequenceBits = 0;
+	sequenceTriggers.clear();
+	pressIndex = 0;
+}
+
+bool InputTriggerEngine::empty() const
+{
+	return triggers.empty();
+}
+
+bool InputTriggerEngine::isTimed(uint32_t id) const
+{
+	const InputTriggerType type = triggers[id].type;
+	return type == +InputTriggerType::tap || type == +InputTriggerType::hold;
+}
+
+bool InputTriggerEngine::isActive(uint32_t id) const
+{
+	return triggers[id].active;
+}
+
+void InputTriggerEngine::update(Ds4Buttons_t held, Ds4Buttons_t pressed, Stopwatch::TimePoint now)
+{
+	if (pressed != 0)
+	{
+		for (size_t i = 0; i < buttonCount; ++i)
+		{
+			if (pressed & Ds4Buttons_values[i])
+			{
+				press(i, held, now);
+			}
+		}
+	}
+
+	if (!pending.empty())
+	{
+		updatePending(held, now);
+	}
+}
+
+void InputTriggerEngine::addPending(uint32_t id)
+{
+	TriggerState& trigger = triggers[id];
+
+	if (!trigger.pending)
+	{
+		trigger.pending = true;
+		pending.push_back(id);
+	}
+}
+
+void InputTriggerEngine::press(size_t button, Ds4Buttons_t held, Stopwatch::TimePoint now)
+{
+	pressTimes[button] = now;
+
+	pressIndex = (pressIndex + 1) % pressHistory.size();
+	pressHistory[pressIndex] = now;
+
+	// Every sequence advances by one step: a step matches if the previous step of its sequence
+	// matched the last press (or it is the first step) and it accepts this button.
+	// Bits carried over from the end of one sequence land on the start of the next, which is always set anyway.
+	const std::vector<uint64_t>& symbols = sequenceSymbols[button];
+	uint64_t carry = 0;
+
+	for (size_t w = 0; w < sequenceState.size(); ++w)
+	{
+		const uint64_t shifted = (sequenceState[w] << 1) | carry;
+		carry = sequenceState[w] >> 63;
+
+		sequenceState[w] = (shifted | sequenceStart[w]) & symbols[w];
+
+		for (uint64_t accepted = sequenceState[w] & sequenceAccept[w]; accepted != 0; accepted &= accepted - 1)
+		{
+			const uint32_t id = sequenceTriggers[w * 64 + std::countr_zero(accepted)];
+			TriggerState& trigger = triggers[id];
+
+			// the first step of a sequence which just ended was this many presses ago
+			const Stopwatch::TimePoint start = pressHistory[(pressIndex + pressHistory.size() - (trigger.length - 1)) % pressHistory.size()];
+
+			if (now - start <= trigger.window)
+			{
+				trigger.active = true;
+				addPending(id);
+			}
+		}
+	}
+
+	for (const uint32_t id : triggersByButton[button])
+	{
+		TriggerState& trigger = triggers[id];
+
+		if ((held & trigger.buttons) != trigger.buttons)
+		{
+			continue;
+		}
+
+		if (trigger.type == +InputTriggerType::chord)
+		{
+			Stopwatch::TimePoint first = now;
+
+			for (size_t i = 0; i < buttonCount; ++i)
+			{
+				if (trigger.buttons & Ds4Buttons_values[i])
+				{
+					first = std::min(first, pressTimes[i]);
+				}
+			}
+
+			if (now - first <= trigger.window)
+			{
+				trigger.active = true;
+				addPending(id);
+			}
+		}
+		else
+		{
+			trigger.armed     = true;
+			trigger.armedTime = now;
+			addPending(id);
+		}
+	}
+}
+
+void InputTriggerEngine::updatePending(Ds4Buttons_t held, Stopwatch::TimePoint now)
+{
+	for (size_t i = 0; i < pending.size();)
+	{
+		const uint32_t id = pending[i];
+		TriggerState& trigger = triggers[id];
+
+		const bool isHeld = (held & trigger.buttons) == trigger.buttons;
+
+		switch (trigger.type)
+		{
+			case InputTriggerType::chord:
+				trigger.active = trigger.active && isHeld;
+				break;
+
+			case InputTriggerType::sequence:
+				// the last step is matched by any one of its buttons
+				trigger.active = trigger.active && (held & trigger.buttons) != 0;
+				break;
+
+			case InputTriggerType::hold:
+				if (!isHeld)
+				{
+					trigger.armed  = false;
+					trigger.active = false;
+				}
+				else if (trigger.armed && now - trigger.armedTime >= trigger.window)
+				{
+					trigger.armed  = false;
+					trigger.active = true;
+				}
+
+				break;
+
+			case InputTriggerType::tap:
+				if (trigger.active && now >= trigger.activeUntil)
+				{
+					trigger.active = false;
+				}
+
+				if (trigger.armed && !isHeld)
+				{
+					trigger.armed = false;
+
+					if (now - trigger.armedTime <= trigger.window)
+					{
+						trigger.active      = true;
+						trigger.activeUntil = now + InputTrigger::tapDuration;
+					}
+				}
+
+				break;
+
+			default:
+				break;
+		}
+
+		if (trigger.active || trigger.armed)
+		{
+			++i;
+			continue;
+		}
+
+		trigger.pending = false;
+		pending[i] = pending.back();
+		pending.pop_back();
+	}
+}
@@ -0,0 +1,206 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <tuple>
+#include <vector>
+
+#include <enum.h>
+
+#include "enums.h"
+#include "JsonData.h"
+#include "Stopwatch.h"
+
+BETTER_ENUM(InputTriggerType, int,
+            /** \brief No type specified. Considered invalid. */
+            none,
+            /** \brief Every button of the single step is held, and the last was pressed within \c window of the first. */
+            chord,
+            /** \brief Each step is pressed in order with no other presses in between, all within \c window. */
+            sequence,
+            /** \brief Every button of the single step is held, then released within \c window. */
+            tap,
+            /** \brief Every button of the single step is held for at least \c window. */
+            hold)
+
+/**
+ * \brief A button trigger which depends on the timing or order of presses rather than only on which buttons are held.
+ * \sa InputType::trigger, InputTriggerEngine
+ */
+class InputTrigger : public JsonData
+{
+public:
+	/**
+	 * \brief The longest supported \c InputTriggerType::sequence.
+	 */
+	static constexpr size_t maxSequenceLength = 64;
+
+	/**
+	 * \brief How long a tap remains active after being released, since it has no duration of its own.
+	 */
+	static constexpr std::chrono::milliseconds tapDuration { 50 };
+
+	InputTriggerType type = InputTriggerType::none;
+
+	/**
+	 * \brief The buttons of each step. A sequence step is matched by pressing any one of its buttons;
+	 * every other type has a single step whose buttons must all be held.
+	 */
+	std::vector<Ds4Buttons_t> steps;
+
+	/**
+	 * \brief The time limit or threshold of the trigger. \sa InputTriggerType
+	 */
+	std::chrono::milliseconds window { 0 };
+
+	InputTrigger() = default;
+	InputTrigger(const InputTrigger&) = default;
+	InputTrigger& operator=(const InputTrigger&) = default;
+
+	/**
+	 * \brief Gets every button used by any step.
+	 */
+	[[nodiscard]] Ds4Buttons_t buttons() const;
+
+	/**
+	 * \brief Indicates if the trigger is well-formed for its type.
+	 */
+	[[nodiscard]] bool isValid() const;
+
+	bool operator==(const InputTrigger& other) const;
+	bool operator!=(const InputTrigger& other) const;
+
+	void readJson(const nlohmann::json& json) override;
+	void writeJson(nlohmann::json& json) const override;
+};
+
+/**
+ * \brief Evaluates every \c InputTrigger of a profile from the stream of pressed and released buttons.
+ * Sequences are matched together by a bit-parallel (shift-and) automaton, where each step of each
+ * sequence is one bit; a press advances every sequence at once in a handful of word operations,
+ * regardless of how many sequences there are. Only triggers which are armed or active are visited per tick.
+ */
+class InputTriggerEngine
+{
+	static constexpr size_t buttonCount = std::tuple_size_v<decltype(Ds4Buttons_values)>;
+
+	struct TriggerState
+	{
+		InputTriggerType type = InputTriggerType::none;
+
+		/**
+		 * \brief The buttons which must be held for the trigger to be active.
+		 * For a sequence, these are the buttons of its last step, any one of which must be held.
+		 */
+		Ds4Buttons_t buttons = 0;
+
+		Stopwatch::Duration window {};
+
+		/**
+		 * \brief The number of steps of a sequence.
+		 */
+		uint32_t length = 0;
+
+		bool active = false;
+
+		/**
+		 * \brief A tap or hold whose buttons are all held, but which has not yet been decided.
+		 */
+		bool armed = false;
+
+		/**
+		 * \brief Indicates if the trigger is in \c pending.
+		 */
+		bool pending = false;
+
+		/**
+		 * \brief When a tap or hold was armed.
+		 */
+		Stopwatch::TimePoint armedTime {};
+
+		/**
+		 * \brief When an active tap ends.
+		 */
+		Stopwatch::TimePoint activeUntil {};
+	};
+
+	std::vector<TriggerState> triggers;
+
+	/**
+	 * \brief Triggers which are armed or active and must be checked every tick.
+	 */
+	std::vector<uint32_t> pending;
+
+	/**
+	 * \brief Chord, tap and hold triggers which may be completed by a press of each button.
+	 */
+	std::array<std::vector<uint32_t>, buttonCount> triggersByButton;
+
+	/**
+	 * \brief The shift-and automaton. Bit \c i of \c sequenceState is set if step \c i of its sequence
+	 * was matched by the last press. \c sequenceStart has the first bit of every sequence set, and
+	 * \c sequenceAccept the last. \c sequenceSymbols has, for each button, the bits of every step it matches.
+	 */
+	std::vector<uint64_t> sequenceState;
+	std::vector<uint64_t> sequenceStart;
+	std::vector<uint64_t> sequenceAccept;
+	std::array<std::vector<uint64_t>, buttonCount> sequenceSymbols;
+	size_t sequenceBits = 0;
+
+	/**
+	 * \brief The trigger of the sequence ending at each bit of \c sequenceAccept.
+	 */
+	std::vector<uint32_t> sequenceTriggers;
+
+	/**
+	 * \brief The times of the most recent button presses, used to check the window of a matched sequence.
+	 */
+	std::array<Stopwatch::TimePoint, InputTrigger::maxSequenceLength> pressHistory {};
+	size_t pressIndex = 0;
+
+	/**
+	 * \brief The time each button was last pressed.
+	 */
+	std::array<Stopwatch::TimePoint, buttonCount> pressTimes {};
+
+public:
+	/**
+	 * \brief Adds a trigger to be evaluated.
+	 * \return The ID of the trigger, or \c std::nullopt if it is not valid.
+	 */
+	std::optional<uint32_t> add(const InputTrigger& trigger);
+
+	/**
+	 * \brief Removes every trigger.
+	 */
+	void clear();
+
+	[[nodiscard]] bool empty() const;
+
+	/**
+	 * \brief Indicates if a trigger can change state without a button being pressed or released,
+	 * i.e. it is a tap or a hold.
+	 */
+	[[nodiscard]] bool isTimed(uint32_t id) const;
+
+	/**
+	 * \brief Indicates if a trigger is active as of the last call to \c update.
+	 */
+	[[nodiscard]] bool isActive(uint32_t id) const;
+
+	/**
+	 * \brief Advances every trigger by one tick.
+	 * Releases are detected from \p held, since only armed and active triggers can be affected by one.
+	 * \param held Buttons currently held.
+	 * \param pressed Buttons pressed since the last tick.
+	 * \param now The time of this tick.
+	 */
+	void update(Ds4Buttons_t held, Ds4Buttons_t pressed, Stopwatch::TimePoint now);
+
+private:
+	void addPending(uint32_t id);
+	void press(size_t button, Ds4Buttons_t held, Stopwatch::TimePoint now);
+	void updatePending(Ds4Buttons_t held, Stopwatch::TimePoint now);
+};
@@ -2,10 +2,12 @@
 
 #include <unordered_set>
 
+#include "InputSinks.h"
+
 /**
  * \brief Object used for simulating keyboard input.
  */
-class KeyboardSimulator
+class KeyboardSimulator : public IKeyboardSink
 {
 	std::unordered_set<int> pressedKeys;
 
@@ -13,7 +15,7 @@ public:
 	KeyboardSimulator() = default;
 	KeyboardSimulator(KeyboardSimulator&&) = default;
 
-	~KeyboardSimulator();
+	~KeyboardSimulator() override;
 
 	KeyboardSimulator& operator=(KeyboardSimulator&&) = default;
 
@@ -31,13 +33,13 @@ public:
 	 * \brief Releases a key specified by \a keyCode.
 	 * \param keyCode The key code to release.
 	 */
-	void keyUp(int keyCode);
+	void keyUp(int keyCode) override;
 
 	/**
 	 * \brief Presses a key specified by \a keyCode.
 	 * \param keyCode The key code to press.
 	 */
-	void keyDown(int keyCode);
+	void keyDown(int keyCode) override;
 
 	/**
 	 * \brief Presses or releases a key specified by \a keyCode.
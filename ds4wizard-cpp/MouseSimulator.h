@@ -2,11 +2,12 @@
 
 #include <unordered_set>
 #include "enums.h"
+#include "InputSinks.h"
 
 /**
  * \brief An object for simulating mouse input.
  */
-class MouseSimulator
+class MouseSimulator : public IMouseSink
 {
 	std::unordered_set<MouseButton::_integral> pressedButtons;
 
@@ -14,7 +15,7 @@ public:
 	MouseSimulator() = default;
 	MouseSimulator(MouseSimulator&&) = default;
 
-	~MouseSimulator();
+	~MouseSimulator() override;
 
 	/**
 	 * \brief Explicitly disallow copying.
@@ -32,20 +33,20 @@ public:
 	 * \brief Releases a mouse button.
 	 * \param button The button to release.
 	 */
-	void buttonUp(MouseButton button);
+	void buttonUp(MouseButton button) override;
 
 	/**
 	 * \brief Presses a mouse button.
 	 * \param button The button to press.
 	 */
-	void buttonDown(MouseButton button);
+	void buttonDown(MouseButton button) override;
 
 	/**
 	 * \brief Moves the cursor relative to its current position.
 	 * \param dx X delta to move by, in pixels.
 	 * \param dy Y delta to move by, in pixels.
 	 */
-	static void moveBy(int dx, int dy);
+	void moveBy(int dx, int dy) override;
 
 	/**
 	 * \brief Presses or releases a mouse button.
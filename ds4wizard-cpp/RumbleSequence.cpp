@@ -62,6 +62,23 @@ void RumbleSequence::update(float deltaTime)
 	}
 }
 
+std::optional<Stopwatch::Duration> RumbleSequence::timeUntilUpdate() const
+{
+	if (!currentElement.has_value() || sequence.empty())
+	{
+		return Stopwatch::Duration::zero();
+	}
+
+	// linear blending needs to be interpolated continuously
+	if (currentElement->blending != RumbleSequenceBlending::none)
+	{
+		return ISimulator::timeUntilUpdate();
+	}
+
+	return std::max(Stopwatch::Duration::zero(),
+	                duration_cast<Stopwatch::Duration>(milliseconds(currentElement->durationMilliseconds)) - stopwatch.elapsed());
+}
+
 void RumbleSequence::add(const RumbleSequenceElement& element)
 {
 	sequence.push(element);
@@ -91,7 +108,12 @@ void RumbleTimer::update(float deltaTime)
 	parent->setRumble(left, right);
 }
 
-void RumbleTimer::onActivate(float deltaTime)
+std::optional<Stopwatch::Duration> RumbleTimer::timeUntilUpdate() const
+{
+	return std::max(Stopwatch::Duration::zero(), duration - stopwatch.elapsed());
+}
+
+void RumbleTimer::onActivate(float /*deltaTime*/)
 {
 	reset();
 }
@@ -32,6 +32,7 @@ public:
 	explicit RumbleSequence(InputSimulator* parent);
 
 	void update(float deltaTime) override;
+	[[nodiscard]] std::optional<Stopwatch::Duration> timeUntilUpdate() const override;
 	void add(const RumbleSequenceElement& element);
 };
 
@@ -50,5 +51,6 @@ public:
 	void reset();
 
 	void update(float deltaTime) override;
+	[[nodiscard]] std::optional<Stopwatch::Duration> timeUntilUpdate() const override;
 	void onActivate(float deltaTime) override;
 };
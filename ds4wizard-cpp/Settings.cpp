@@ -5,7 +5,8 @@ bool Settings::operator==(const Settings& rhs) const
 {
 	return preferredConnection == rhs.preferredConnection &&
 	       startMinimized      == rhs.startMinimized &&
-	       minimizeToTray      == rhs.minimizeToTray;
+	       minimizeToTray      == rhs.minimizeToTray &&
+	       sharedDeviceThread  == rhs.sharedDeviceThread;
 }
 
 bool Settings::operator!=(const Settings& rhs) const
@@ -29,6 +30,11 @@ void Settings::readJson(const nlohmann::json& json)
 	{
 		minimizeToTray = json["minimizeToTray"];
 	}
+
+	if (json.find("sharedDeviceThread") != json.end())
+	{
+		sharedDeviceThread = json["sharedDeviceThread"];
+	}
 }
 
 void Settings::writeJson(nlohmann::json& json) const
@@ -36,4 +42,5 @@ void Settings::writeJson(nlohmann::json& json) const
 	json["preferredConnection"] = preferredConnection._to_string();
 	json["startMinimized"]      = startMinimized;
 	json["minimizeToTray"]      = minimizeToTray;
+	json["sharedDeviceThread"]  = sharedDeviceThread;
 }
@@ -25,6 +25,13 @@ struct Settings : JsonData
 	 */
 	bool minimizeToTray = true;
 
+	/**
+	 * \brief If \c true, all devices are serviced by a single shared thread rather than a thread each.
+	 * Only applies to devices connected after it is changed.
+	 * \sa Ds4DeviceReactor
+	 */
+	bool sharedDeviceThread = false;
+
 	Settings& operator=(const Settings& rhs) = default;
 	bool operator==(const Settings& rhs) const;
 	bool operator!=(const Settings& rhs) const;
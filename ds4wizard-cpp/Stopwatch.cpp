@@ -1,5 +1,6 @@
 #include "pch.h"
 #include "Stopwatch.h"
+#include "TickClock.h"
 
 Stopwatch::Stopwatch(bool start_now)
 {
@@ -12,19 +13,19 @@ Stopwatch::Stopwatch(bool start_now)
 void Stopwatch::start()
 {
 	running_ = true;
-	start_time_ = Clock::now();
+	start_time_ = TickClock::now();
 }
 
 Stopwatch::Duration Stopwatch::stop()
 {
-	end_time_ = Clock::now();
+	end_time_ = TickClock::now();
 	running_ = false;
 	return elapsed();
 }
 
 Stopwatch::Duration Stopwatch::elapsed() const
 {
-	return (running_ ? Clock::now() : end_time_) - start_time_;
+	return (running_ ? TickClock::now() : end_time_) - start_time_;
 }
 
 bool Stopwatch::running() const
@@ -2,6 +2,9 @@
 
 #include <chrono>
 
+/**
+ * \brief Measures time by \c TickClock, so every stopwatch read while handling an input report sees the same time.
+ */
 class Stopwatch
 {
 public:
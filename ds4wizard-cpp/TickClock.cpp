@@ -0,0 +1,72 @@
+#include "pch.h"
+
+#include "TickClock.h"
+
+namespace
+{
+	thread_local const VirtualClock* source = nullptr;
+	thread_local std::optional<Stopwatch::TimePoint> tickTime;
+}
+
+VirtualClock::VirtualClock(Stopwatch::TimePoint time)
+	: time_(time)
+{
+}
+
+Stopwatch::TimePoint VirtualClock::now() const
+{
+	return time_;
+}
+
+void VirtualClock::set(Stopwatch::TimePoint time)
+{
+	time_ = time;
+}
+
+void VirtualClock::advance(Stopwatch::Duration duration)
+{
+	time_ += duration;
+}
+
+Stopwatch::TimePoint TickClock::now()
+{
+	return tickTime.has_value() ? *tickTime : sample();
+}
+
+Stopwatch::TimePoint TickClock::sample()
+{
+	return source != nullptr ? source->now() : Stopwatch::Clock::now();
+}
+
+bool TickClock::inTick()
+{
+	return tickTime.has_value();
+}
+
+TickClock::Tick::Tick()
+	: previous(tickTime),
+	  time_(sample())
+{
+	tickTime = time_;
+}
+
+TickClock::Tick::~Tick()
+{
+	tickTime = previous;
+}
+
+Stopwatch::TimePoint TickClock::Tick::time() const
+{
+	return time_;
+}
+
+TickClock::ScopedSource::ScopedSource(const VirtualClock& clock)
+	: previous(source)
+{
+	source = &clock;
+}
+
+TickClock::ScopedSource::~ScopedSource()
+{
+	source = previous;
+}
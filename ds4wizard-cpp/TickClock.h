@@ -0,0 +1,86 @@
+#pragma once
+
+#include <optional>
+
+#include "Stopwatch.h"
+
+/**
+ * \brief A clock which only moves when told to, so that anything timed by \c TickClock
+ * behaves the same on every run regardless of how long processing actually takes.
+ * \sa TickClock::ScopedSource
+ */
+class VirtualClock
+{
+	Stopwatch::TimePoint time_ {};
+
+public:
+	VirtualClock() = default;
+	explicit VirtualClock(Stopwatch::TimePoint time);
+
+	[[nodiscard]] Stopwatch::TimePoint now() const;
+
+	void set(Stopwatch::TimePoint time);
+	void advance(Stopwatch::Duration duration);
+};
+
+/**
+ * \brief The time shared by everything which handles an input report.
+ * The clock is sampled once when a \c Tick begins, and every read of \c now on that thread
+ * returns the same time until the tick ends, so that timers compared within a report agree
+ * and the clock is not read again for each of them.
+ * Outside of a tick, \c now reads the clock directly.
+ */
+class TickClock
+{
+public:
+	/**
+	 * \brief The time of the tick in progress on the calling thread, or the current time if there is none.
+	 */
+	[[nodiscard]] static Stopwatch::TimePoint now();
+
+	/**
+	 * \brief Reads the clock of the calling thread, ignoring any tick in progress.
+	 * This is the \c VirtualClock installed by \c ScopedSource if any, otherwise \c Stopwatch::Clock.
+	 */
+	[[nodiscard]] static Stopwatch::TimePoint sample();
+
+	/**
+	 * \brief Indicates if a tick is in progress on the calling thread.
+	 */
+	[[nodiscard]] static bool inTick();
+
+	/**
+	 * \brief Samples the clock and holds the time for the calling thread until destroyed.
+	 * Ticks may be nested, e.g. when one thread runs several devices; the outer tick's time is restored afterward.
+	 */
+	class Tick
+	{
+		std::optional<Stopwatch::TimePoint> previous;
+		Stopwatch::TimePoint time_;
+
+	public:
+		Tick();
+		~Tick();
+
+		Tick(const Tick&) = delete;
+		Tick& operator=(const Tick&) = delete;
+
+		[[nodiscard]] Stopwatch::TimePoint time() const;
+	};
+
+	/**
+	 * \brief Replaces the clock of the calling thread with a \c VirtualClock until destroyed.
+	 * The virtual clock must outlive this object.
+	 */
+	class ScopedSource
+	{
+		const VirtualClock* previous;
+
+	public:
+		explicit ScopedSource(const VirtualClock& clock);
+		~ScopedSource();
+
+		ScopedSource(const ScopedSource&) = delete;
+		ScopedSource& operator=(const ScopedSource&) = delete;
+	};
+};
@@ -34,7 +34,8 @@ bool TrackballSettings::operator==(TrackballSettings& other) const
 	       ballVibration == other.ballVibration &&
 	       gmath::near_equal(touchFriction, other.touchFriction) &&
 	       gmath::near_equal(ballFriction, other.ballFriction) &&
-	       gmath::near_equal(ballSpeed, other.ballSpeed);
+	       gmath::near_equal(ballSpeed, other.ballSpeed) &&
+	       gmath::near_equal(simulationRate, other.simulationRate);
 }
 
 bool TrackballSettings::operator!=(TrackballSettings& other) const
@@ -57,6 +58,11 @@ void TrackballSettings::readJson(const nlohmann::json& json)
 	touchFriction = json["touchFriction"];
 	ballFriction  = json["ballFriction"];
 	ballSpeed     = json["ballSpeed"];
+
+	if (json.find("simulationRate") != json.end())
+	{
+		simulationRate = json["simulationRate"];
+	}
 }
 
 void TrackballSettings::writeJson(nlohmann::json& json) const
@@ -66,6 +72,7 @@ void TrackballSettings::writeJson(nlohmann::json& json) const
 	json["touchFriction"]  = touchFriction;
 	json["ballFriction"]   = ballFriction;
 	json["ballSpeed"]      = ballSpeed;
+	json["simulationRate"] = simulationRate;
 }
 
 TrackballSimulator::TrackballSimulator(const TrackballSettings& settings, Ds4TouchRegion* region, InputSimulator* parent)
@@ -157,8 +164,43 @@ TrackballSimulator::TrackballState TrackballSimulator::applyDirectionalForce(boo
 
 void TrackballSimulator::update(float deltaTime)
 {
-	simulate(deltaTime, Ds4Buttons::touch1);
-	//simulate(deltaTime, Ds4Buttons::touch2);
+	const float rate = settings.simulationRate > 0.0f ? settings.simulationRate : frameRate;
+	const float step = frameRate / rate;
+
+	accumulator = std::min(accumulator + deltaTime, maxAccumulatedFrames);
+
+	// touches only change once per report, so their force holds for every step in between
+	Vector2 direction {};
+	float force = 0.0f;
+	const bool touching = getTouchForce(direction, force);
+
+	while (accumulator >= step)
+	{
+		previousVelocity = velocity;
+		lastState = applyDirectionalForce(touching, direction, force, step);
+		accumulator -= step;
+	}
+
+	// rumble is reset every tick, so re-apply the state of the last step even if no step was taken
+	applyRumble(lastState);
+}
+
+Vector2 TrackballSimulator::interpolatedVelocity() const
+{
+	const float rate = settings.simulationRate > 0.0f ? settings.simulationRate : frameRate;
+	const float alpha = std::clamp(accumulator / (frameRate / rate), 0.0f, 1.0f);
+
+	return previousVelocity + (velocity - previousVelocity) * alpha;
+}
+
+std::optional<Stopwatch::Duration> TrackballSimulator::timeUntilUpdate() const
+{
+	if (rolling())
+	{
+		return ISimulator::timeUntilUpdate();
+	}
+
+	return std::nullopt;
 }
 
 void TrackballSimulator::accelerate(const Vector2& direction, float factor, float deltaTime)
@@ -210,24 +252,29 @@ void TrackballSimulator::decelerate(float deltaTime)
 	velocity = Vector2::clamp(velocity, -settings.ballSpeed, settings.ballSpeed);
 }
 
-template <ptrdiff_t N>
-void selectPoints(const circular_buffer<Ds4TouchHistory, N>& points,
-                  std::optional<Ds4TouchHistory>& newest,
-                  std::optional<Ds4TouchHistory>& oldest)
+/**
+ * \brief The span of recent touch samples a touch's velocity is measured over, and the time
+ * that velocity is scaled by to produce a force. \sa TrackballSimulator::getTouchForce
+ */
+static constexpr auto touchWindow = std::chrono::milliseconds(125);
+
+void selectPoints(const Ds4TouchHistoryView& points,
+                  std::optional<Ds4TouchSample>& newest,
+                  std::optional<Ds4TouchSample>& oldest)
 {
 	newest = points.newest();
 	oldest = points.oldest();
 
-	static constexpr auto threshold = std::chrono::milliseconds(125);
-
-	for (ptrdiff_t i = 0; i < points.count - 1; i++)
+	for (uint32_t i = 0; i < points.size() - 1; i++)
 	{
-		if (newest->timestamp < points[i].timestamp)
+		const auto elapsed = Ds4TouchHistory::elapsed(points[i], *newest);
+
+		if (elapsed.count() < 0)
 		{
 			continue;
 		}
 
-		if (newest->timestamp - points[i].timestamp < threshold)
+		if (elapsed < touchWindow)
 		{
 			oldest = points[i];
 			break;
@@ -235,43 +282,65 @@ void selectPoints(const circular_buffer<Ds4TouchHistory, N>& points,
 	}
 }
 
-void TrackballSimulator::simulate(float deltaTime, Ds4Buttons_t touchId)
+bool TrackballSimulator::getTouchForce(Vector2& direction, float& force) const
 {
 	const auto width  = static_cast<short>(region->right - region->left);
 	const auto height = static_cast<short>(region->bottom - region->top);
 
-	std::optional<Ds4TouchHistory> newest;
-	std::optional<Ds4TouchHistory> oldest;
+	bool touching = false;
+	Vector2 combined {};
 
-	const bool touching = region->isTouchActive(touchId);
-	
-	if (touching)
+	for (const Ds4Buttons_t touchId : { Ds4Buttons::touch1, Ds4Buttons::touch2 })
 	{
+		if (!region->isTouchActive(touchId))
+		{
+			continue;
+		}
+
+		touching = true;
+
+		std::optional<Ds4TouchSample> newest;
+		std::optional<Ds4TouchSample> oldest;
+
 		selectPoints(region->getPoints(touchId), newest, oldest);
-	}
 
-	Vector2 direction {};
-	float force = 0.0f;
+		if (!newest.has_value() || !oldest.has_value())
+		{
+			continue;
+		}
+
+		// The history holds a fixed number of reports, which covers less time the faster the connection
+		// reports, so the displacement is divided by the time it took to get a velocity. Scaled by the
+		// window, a touch moving across the whole region within it is a force of one.
+		const float seconds = std::chrono::duration<float>(Ds4TouchHistory::elapsed(*oldest, *newest)).count();
+
+		if (seconds <= 0.0f)
+		{
+			continue;
+		}
 
-	if (newest.has_value() && oldest.has_value())
-	{
 		auto pa = newest->point;
 		auto pb = oldest->point;
 
 		region->clamp(pa);
 		region->clamp(pb);
 
-		direction = {
+		const Vector2 displacement = {
 			static_cast<float>(pb.x - pa.x) / static_cast<float>(width),
 			static_cast<float>(pb.y - pa.y) / static_cast<float>(height)
 		};
 
-		force = direction.length();
-		direction.normalize();
+		combined += displacement * (std::chrono::duration<float>(touchWindow).count() / seconds);
 	}
 
-	const TrackballState state = applyDirectionalForce(touching, direction, force, deltaTime);
+	force     = combined.length();
+	direction = combined.normalized();
 
+	return touching;
+}
+
+void TrackballSimulator::applyRumble(TrackballState state)
+{
 	const float f = velocity.length() / settings.ballSpeed;
 
 	const auto left  = std::clamp(f * settings.touchVibration.factor * 255.0f, 0.0f, 1.0f);
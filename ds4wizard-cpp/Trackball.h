@@ -29,6 +29,12 @@ struct TrackballSettings : JsonData
 
 	float ballSpeed = 100.0f;
 
+	/**
+	 * \brief The rate, in steps per second, at which the ball is simulated.
+	 * The ball moves the same regardless of how often the device sends reports.
+	 */
+	float simulationRate = 1000.0f;
+
 	bool operator==(TrackballSettings& other) const;
 	bool operator!=(TrackballSettings& other) const;
 
@@ -38,17 +44,7 @@ struct TrackballSettings : JsonData
 
 class TrackballSimulator : public ISimulator
 {
-	Ds4TouchRegion* region;
-	std::shared_ptr<RumbleTimer> rumbleTimer;
-
 public:
-	TrackballSettings settings;
-
-	TrackballSimulator(const TrackballSettings& settings, Ds4TouchRegion* region, InputSimulator* parent);
-
-	Vector2 velocity {};
-	[[nodiscard]] bool rolling() const;
-
 	/**
 	 * \brief Indicates the state of the emulated trackball.
 	 */
@@ -64,6 +60,51 @@ public:
 		accelerating
 	};
 
+private:
+	/**
+	 * \brief The rate of the frames \c update measures \c deltaTime in. \sa InputSimulator::deltaTime
+	 */
+	static constexpr float frameRate = 60.0f;
+
+	/**
+	 * \brief The most time, in frames, carried over between updates; anything beyond is dropped
+	 * rather than simulated all at once after a stall.
+	 */
+	static constexpr float maxAccumulatedFrames = 15.0f;
+
+	Ds4TouchRegion* region;
+	std::shared_ptr<RumbleTimer> rumbleTimer;
+
+	/**
+	 * \brief Time, in frames, not yet simulated because it is less than one step.
+	 */
+	float accumulator = 0.0f;
+
+	/**
+	 * \brief The velocity before the last step, from which \c interpolatedVelocity is blended.
+	 */
+	Vector2 previousVelocity {};
+
+	TrackballState lastState = TrackballState::stopped;
+
+public:
+	TrackballSettings settings;
+
+	TrackballSimulator(const TrackballSettings& settings, Ds4TouchRegion* region, InputSimulator* parent);
+
+	/**
+	 * \brief The velocity of the ball as of the last simulation step.
+	 */
+	Vector2 velocity {};
+
+	[[nodiscard]] bool rolling() const;
+
+	/**
+	 * \brief The velocity of the ball between the last two simulation steps, according to the time
+	 * left over since the last step, so that output changes smoothly regardless of report timing.
+	 */
+	[[nodiscard]] Vector2 interpolatedVelocity() const;
+
 	/**
 	 * \brief Apply a force to the ball in a given direction.
 	 *        If \p force is zero, the ball will slow down according to \p touching.
@@ -78,12 +119,17 @@ public:
 	TrackballState applyDirectionalForce(bool touching, Vector2 targetDirection, float force, float deltaTime);
 
 	/**
-	 * \brief Update the ball without any external influence.
-	 * \param deltaTime Delta time to be used in acceleration and deceleration.
-	 * \return A \c TrackballState indicating the state of the ball after the call.
+	 * \brief Simulates the ball in fixed steps of \c settings.simulationRate covering \p deltaTime,
+	 * applying the force of both touch points.
+	 * \param deltaTime Time elapsed since the last update, in frames of \c frameRate.
 	 */
 	void update(float deltaTime) override;
 
+	/**
+	 * \brief Requests continuous updates while the ball is rolling.
+	 */
+	[[nodiscard]] std::optional<Stopwatch::Duration> timeUntilUpdate() const override;
+
 private:
 	/** \brief Accelerate the ball! */
 	void accelerate(const Vector2& direction, float factor, float deltaTime);
@@ -92,5 +138,13 @@ private:
 	/** \brief Allow the ball to naturally decelerate with nothing but friction. */
 	void decelerate(float deltaTime);
 	
-	void simulate(float deltaTime, Ds4Buttons_t touchId);
+	/**
+	 * \brief Gets the combined force of every touch point on the ball.
+	 * \param direction The direction of the force, normalized.
+	 * \param force The amount of \c settings.ballSpeed to apply.
+	 * \return \c true if any touch point is touching the ball.
+	 */
+	bool getTouchForce(Vector2& direction, float& force) const;
+
+	void applyRumble(TrackballState state);
 };
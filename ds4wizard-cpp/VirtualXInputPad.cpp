@@ -0,0 +1,128 @@
+#include "pch.h"
+
+#include <chrono>
+#include <thread>
+
+#include "VirtualXInputPad.h"
+#include "Ds4Device.h"
+#include "Logger.h"
+#include "program.h"
+
+using namespace std::chrono;
+
+VirtualXInputPad::VirtualXInputPad(const Ds4Device* parent)
+	: parent(parent)
+{
+}
+
+bool VirtualXInputPad::connect()
+{
+	if (!open())
+	{
+		return false;
+	}
+
+	if (xinputTarget->connected())
+	{
+		return true;
+	}
+
+	VIGEM_ERROR vigemResult = xinputTarget->connect();
+
+	if (VIGEM_SUCCESS(vigemResult))
+	{
+		return true;
+	}
+
+	// If connecting an emulated XInput controller failed,
+	// it's likely because it's already connected. Disconnect
+	// it before continuing.
+	vigemResult = xinputTarget->disconnect();
+
+	if (!VIGEM_SUCCESS(vigemResult))
+	{
+		// TODO: implement a callback for ViGEm target disconnect failure
+		Logger::writeLine(LogLevel::warning, parent->name(), "ViGEm target connect followed by disconnect failed: " + std::to_string(vigemResult));
+	}
+
+	// Attempt to recover the virtual controller up to 4 times on a 250ms interval.
+	for (size_t i = 0; i < 4; i++)
+	{
+		vigemResult = xinputTarget->connect();
+
+		if (VIGEM_SUCCESS(vigemResult))
+		{
+			break;
+		}
+
+		std::this_thread::yield();
+		std::this_thread::sleep_for(250ms);
+	}
+
+	if (!VIGEM_SUCCESS(vigemResult))
+	{
+		// TODO: implement a callback for ViGEm target connect failure
+		Logger::writeLine(LogLevel::warning, parent->name(), "ViGEm target connect failed: " + std::to_string(vigemResult));
+		return false;
+	}
+
+	return true;
+}
+
+void VirtualXInputPad::disconnect()
+{
+	if (!xinputTarget)
+	{
+		return;
+	}
+
+	const VIGEM_ERROR result = xinputTarget->disconnect();
+
+	if (!VIGEM_SUCCESS(result))
+	{
+		// TODO: implement a callback for ViGEm target disconnect failure
+		Logger::writeLine(LogLevel::warning, parent->name(), "ViGEm target disconnect failed: " + std::to_string(result));
+	}
+
+	vibration_ = 0;
+}
+
+bool VirtualXInputPad::connected() const
+{
+	return xinputTarget && xinputTarget->connected();
+}
+
+void VirtualXInputPad::update(const XInputGamepad& state)
+{
+	if (connected())
+	{
+		xinputTarget->update(state);
+	}
+}
+
+XInputVibration VirtualXInputPad::vibration() const
+{
+	const uint16_t value = vibration_.load(std::memory_order_relaxed);
+	return { static_cast<uint8_t>(value >> 8), static_cast<uint8_t>(value) };
+}
+
+bool VirtualXInputPad::open()
+{
+	if (!Program::driver.isOpen())
+	{
+		return false;
+	}
+
+	if (xinputTarget == nullptr)
+	{
+		xinputTarget = std::make_shared<vigem::XInputTarget>(&Program::driver);
+
+		xinputNotification = xinputTarget->notification.add(
+			[this](auto sender, uint8_t large, uint8_t small, uint8_t led) -> void
+			{
+				vibration_.store(static_cast<uint16_t>((large << 8) | small), std::memory_order_relaxed);
+			});
+	}
+
+	return true;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+#include "Event.h"
+#include "InputSinks.h"
+#include "ViGEmTarget.h"
+
+class Ds4Device;
+
+/**
+ * \brief A virtual XInput pad provided by the ViGEm driver.
+ * The ViGEm target is only created once the driver is available, and is disconnected when destroyed.
+ */
+class VirtualXInputPad : public IVirtualPadSink
+{
+	const Ds4Device* parent;
+
+	std::shared_ptr<vigem::XInputTarget> xinputTarget;
+	EventToken xinputNotification;
+
+	/**
+	 * \brief Motor speeds packed as (left << 8) | right, written by the ViGEm notification thread.
+	 */
+	std::atomic<uint16_t> vibration_ { 0 };
+
+public:
+	/**
+	 * \param parent The device the pad is simulated for; only used for logging.
+	 */
+	explicit VirtualXInputPad(const Ds4Device* parent);
+
+	VirtualXInputPad(const VirtualXInputPad&) = delete;
+	VirtualXInputPad& operator=(const VirtualXInputPad&) = delete;
+
+	bool connect() override;
+	void disconnect() override;
+	[[nodiscard]] bool connected() const override;
+	void update(const XInputGamepad& state) override;
+	[[nodiscard]] XInputVibration vibration() const override;
+
+private:
+	/**
+	 * \brief Acquires a handle to the XInput emulation driver.
+	 * \return \c true on success.
+	 */
+	bool open();
+};
@@ -1,7 +1,24 @@
 #pragma once
-#include <Xinput.h>
 #include <cstdint>
 
+#ifdef _WIN32
+#include <Xinput.h>
+#else
+/**
+ * \brief The layout of \c XINPUT_GAMEPAD from the Windows SDK, for builds without it.
+ */
+struct XINPUT_GAMEPAD
+{
+	uint16_t wButtons;
+	uint8_t  bLeftTrigger;
+	uint8_t  bRightTrigger;
+	int16_t  sThumbLX;
+	int16_t  sThumbLY;
+	int16_t  sThumbRX;
+	int16_t  sThumbRY;
+};
+#endif
+
 /**
  * \brief Simple wrapper for \c XINPUT_GAMEPAD with comparison operators and method for outputting bytes.
  */
@@ -1,36 +1,24 @@
 #include "pch.h"
-#include "ViGEmTarget.h"
+#include "InputSimulator.h"
 #include "XInputRumbleSimulator.h"
 
-XInputRumbleSimulator::XInputRumbleSimulator(InputSimulator* parent)
+XInputRumbleSimulator::XInputRumbleSimulator(InputSimulator* parent, IVirtualPadSink* virtualPad)
 	: ISimulator(parent),
-	  xinputVibration({})
+	  virtualPad(virtualPad)
 {
 }
 
-void XInputRumbleSimulator::update(float deltaTime)
+void XInputRumbleSimulator::update(float /*deltaTime*/)
 {
-	parent->setRumble(static_cast<float>(xinputVibration.wLeftMotorSpeed >> 8) / 255.0f,
-	                  static_cast<float>(xinputVibration.wRightMotorSpeed >> 8) / 255.0f);
-}
+	const XInputVibration vibration = virtualPad->vibration();
 
-void XInputRumbleSimulator::onActivate(float deltaTime)
-{
-	if (xinputTarget)
-	{
-		this->xinputNotification = xinputTarget->notification.add(
-			[&](auto sender, auto large, auto small, auto led) -> void
-			{
-				this->xinputVibration.wLeftMotorSpeed  = (large << 8) | large;
-				this->xinputVibration.wRightMotorSpeed = (small << 8) | small;
-			});
-	}
+	parent->setRumble(static_cast<float>(vibration.leftMotor) / 255.0f,
+	                  static_cast<float>(vibration.rightMotor) / 255.0f);
 }
 
-void XInputRumbleSimulator::onDeactivate(float deltaTime)
+std::optional<Stopwatch::Duration> XInputRumbleSimulator::timeUntilUpdate() const
 {
-	if (xinputTarget)
-	{
-		xinputTarget->notification.remove(this->xinputNotification);
-	}
+	// Vibration changes arrive asynchronously from the virtual pad,
+	// so they have to be polled for. Motors can't respond any faster than this anyway.
+	return timeUntilStep(std::chrono::milliseconds(8));
 }
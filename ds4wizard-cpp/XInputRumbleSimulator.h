@@ -1,25 +1,16 @@
 #pragma once
-#include <memory>
-#include <Xinput.h>
 
 #include "ISimulator.h"
-#include "ViGEmTarget.h"
-#include "Event.h"
+#include "InputSinks.h"
 
 class XInputRumbleSimulator : public ISimulator
 {
-	XINPUT_VIBRATION xinputVibration;
-	EventToken xinputNotification;
+	IVirtualPadSink* virtualPad;
 
 public:
-	std::shared_ptr<vigem::XInputTarget> xinputTarget;
-
-	explicit XInputRumbleSimulator(InputSimulator* parent);
+	XInputRumbleSimulator(InputSimulator* parent, IVirtualPadSink* virtualPad);
 	~XInputRumbleSimulator() override = default;
 
 	void update(float deltaTime) override;
-
-private:
-	void onActivate(float deltaTime) override;
-	void onDeactivate(float deltaTime) override;
+	[[nodiscard]] std::optional<Stopwatch::Duration> timeUntilUpdate() const override;
 };
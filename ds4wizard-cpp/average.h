@@ -1,14 +1,13 @@
 #pragma once
 
-#include <vector>
-
 #include "Stopwatch.h"
 
 template <typename T>
 class timed_average
 {
 private:
-	std::vector<T> points;
+	T sum {};
+	size_t count = 0;
 	Stopwatch stopwatch;
 	Stopwatch::Duration target_duration;
 	T last_average {};
@@ -28,7 +27,8 @@ public:
 		}
 
 		dirty = true;
-		points.push_back(value);
+		sum += value;
+		++count;
 
 		// if we've met our target, cache the result now and clear the buffer
 		if (stopwatch.elapsed() >= target_duration)
@@ -46,21 +46,15 @@ public:
 
 		if (dirty)
 		{
-			T temp {};
-
-			for (const auto& p : points)
-			{
-				temp += p / points.size();
-			}
-
-			last_average = temp;
+			last_average = sum / count;
 			dirty = false;
 		}
 
 		if (stopwatch.elapsed() >= target_duration)
 		{
-			points.clear();
-			points.push_back(last_average);
+			// the next window starts with the last average as its only point
+			sum   = last_average;
+			count = 1;
 			stopwatch.start();
 		}
 
@@ -28,7 +28,7 @@ std::string serializeFlags_ ## TYPE (TYPE ## _t value)
 	return ss.str();                                                            \
 }                                                                               \
                                                                                 \
-void deserializeFlags_ ## TYPE ## (const std::string& input, TYPE ## _t& value) \
+void deserializeFlags_ ## TYPE (const std::string& input, TYPE ## _t& value)    \
 {                                                                               \
 	std::stringstream ss;                                                       \
 	ss << input;                                                                \
@@ -50,16 +50,18 @@ void deserializeFlags_ ## TYPE ## (const std::string& input, TYPE ## _t& value)
 	}                                                                           \
 }
 
-const std::array<InputType_t, 3> InputType_values = {
+const std::array<InputType_t, 4> InputType_values = {
 	InputType::button,
 	InputType::axis,
-	InputType::touchRegion
+	InputType::touchRegion,
+	InputType::trigger
 };
 
 static const char* InputType_names[] = {
 	"button",
 	"axis",
-	"touchRegion"
+	"touchRegion",
+	"trigger"
 };
 
 SERIALIZE_DEF(InputType)
@@ -142,24 +144,6 @@ const std::array<Ds4ButtonsRaw_t, 15> Ds4ButtonsRaw_values = {
 	Ds4ButtonsRaw::touchButton,
 };
 
-static const char* Ds4ButtonsRaw_names[] = {
-	"hat",
-	"square",
-	"cross",
-	"circle",
-	"triangle",
-	"l1",
-	"r1",
-	"l2",
-	"r2",
-	"share",
-	"options",
-	"l3",
-	"r3",
-	"ps",
-	"touchButton",
-};
-
 Hat Ds4ButtonsRaw::getHat(Ds4ButtonsRaw_t value)
 {
 	return static_cast<Hat>(value & hat_mask);
@@ -74,12 +74,14 @@ struct InputType
 		/** \brief Requested input is an axis. */
 		axis = 1 << 1,
 		/** \brief Requested input is a user-configured touch region. */
-		touchRegion = 1 << 2
+		touchRegion = 1 << 2,
+		/** \brief Requested input is a chord, sequence, tap or hold of buttons. \sa InputTrigger */
+		trigger = 1 << 3
 	};
 };
 
 ENUM_FLAGS(InputType);
-ENUM_VALUES(InputType, 3);
+ENUM_VALUES(InputType, 4);
 
 using OutputType_t = uint32_t;
 
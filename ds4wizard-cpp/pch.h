@@ -1,5 +1,8 @@
 #pragma once
 
+// DS4W_HEADLESS builds only the portable mapping engine, without Windows, Qt or ViGEm. \sa CMakeLists.txt
+#ifndef DS4W_HEADLESS
+
 #define QT_IS_BROKEN
 #define QAPPLICATION_CLASS QApplication // for SingleApplication
 
@@ -16,13 +19,15 @@
 #include <shellapi.h>
 #include <Xinput.h>
 
+#endif
+
 // STL
+#include <algorithm>
 #include <array>
 #include <chrono>
 #include <cmath>
 #include <cstdint>
 #include <deque>
-#include <format>
 #include <functional>
 #include <iomanip>
 #include <list>
@@ -32,10 +37,45 @@
 #include <optional>
 #include <span>
 #include <sstream>
+#include <stdexcept>
 #include <string>
 #include <thread>
 #include <unordered_map>
 
+// better-enums
+#include <enum.h>
+
+#include "average.h"
+#include "AxisOptions.h"
+#include "ConnectionType.h"
+#include "DeviceIdleOptions.h"
+#include "DeviceProfile.h"
+#include "DeviceSettingsCommon.h"
+#include "Ds4AutoLightColor.h"
+#include "Ds4Color.h"
+#include "Ds4Input.h"
+#include "Ds4InputData.h"
+#include "Ds4LightOptions.h"
+#include "Ds4Output.h"
+#include "Ds4TouchRegion.h"
+#include "enums.h"
+#include "Event.h"
+#include "gmath.h"
+#include "InputMap.h"
+#include "InputSimulator.h"
+#include "JsonData.h"
+#include "lock.h"
+#include "Pressable.h"
+#include "Stopwatch.h"
+#include "Trackball.h"
+#include "Vector2.h"
+#include "Vector3.h"
+#include "XInputGamepad.h"
+
+#ifndef DS4W_HEADLESS
+
+#include <format>
+
 // Qt
 #include <QDialog>
 #include <QtWidgets/QApplication>
@@ -44,9 +84,6 @@
 
 #include <singleapplication.h>
 
-// better-enums
-#include <enum.h>
-
 // libhid
 #include <hid_handle.h>
 #include <hid_instance.h>
@@ -57,49 +94,24 @@
 #include <ViGEm/Common.h>
 #include <ViGEm/km/BusShared.h>
 
-#include "MapCache.h"
-#include "average.h"
-#include "AxisOptions.h"
 #include "Bluetooth.h"
 #include "busenum.h"
-#include "ConnectionType.h"
-#include "DeviceIdleOptions.h"
-#include "DeviceProfile.h"
 #include "DeviceProfileCache.h"
 #include "DevicePropertiesDialog.h"
 #include "DeviceSettings.h"
-#include "DeviceSettingsCommon.h"
-#include "Ds4AutoLightColor.h"
-#include "Ds4Color.h"
 #include "Ds4Device.h"
 #include "Ds4DeviceManager.h"
-#include "Ds4Input.h"
-#include "Ds4InputData.h"
 #include "Ds4ItemModel.h"
-#include "Ds4LightOptions.h"
-#include "Ds4Output.h"
-#include "Ds4TouchRegion.h"
-#include "enums.h"
-#include "Event.h"
-#include "gmath.h"
-#include "InputMap.h"
-#include "InputSimulator.h"
-#include "JsonData.h"
 #include "KeyboardSimulator.h"
 #include "Latency.h"
-#include "lock.h"
 #include "Logger.h"
 #include "MainWindow.h"
 #include "MouseSimulator.h"
 #include "pathutil.h"
-#include "Pressable.h"
 #include "ProfileEditorDialog.h"
 #include "program.h"
 #include "Settings.h"
-#include "Stopwatch.h"
 #include "stringutil.h"
-#include "Trackball.h"
-#include "Vector2.h"
-#include "Vector3.h"
-#include "XInputGamepad.h"
 #include "MacAddress.h"
+
+#endif
@@ -0,0 +1,225 @@
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <iostream>
+#include <span>
+#include <string>
+
+#include "hid_handle.h"
+#include "hid_instance.h"
+
+using namespace hid;
+
+namespace
+{
+	constexpr size_t reportSize = 64;
+
+	int failures = 0;
+
+	void check(bool condition, const std::string& test, const char* what)
+	{
+		if (!condition)
+		{
+			std::cerr << test << ": " << what << std::endl;
+			++failures;
+		}
+	}
+
+	/**
+	 * \brief A fake hidraw node: \c device is opened by a \c HidInstance, and reports are written to \c peer.
+	 * \c SOCK_SEQPACKET keeps each write a separate report, as hidraw does.
+	 */
+	struct FakeDevice
+	{
+		int device = -1;
+		int peer = -1;
+
+		static FakeDevice socketPair()
+		{
+			std::array<int, 2> fds {};
+			socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, fds.data());
+			return { fds[0], fds[1] };
+		}
+
+		/**
+		 * \brief A pipe signals a closed peer with \c EPOLLHUP alone rather than as a readable end of file.
+		 */
+		static FakeDevice pipe()
+		{
+			std::array<int, 2> fds {};
+			::pipe(fds.data());
+			return { fds[0], fds[1] };
+		}
+
+		void send(std::span<const uint8_t> report) const
+		{
+			::write(peer, report.data(), report.size());
+		}
+
+		void closePeer()
+		{
+			::close(peer);
+			peer = -1;
+		}
+
+		FakeDevice(int device, int peer)
+			: device(device),
+			  peer(peer)
+		{
+		}
+
+		FakeDevice(const FakeDevice&) = delete;
+		FakeDevice& operator=(const FakeDevice&) = delete;
+
+		~FakeDevice()
+		{
+			if (peer >= 0)
+			{
+				::close(peer);
+			}
+		}
+	};
+
+	bool openFake(HidInstance& instance, FakeDevice& fake)
+	{
+		instance.inputBuffer.resize(reportSize);
+		return instance.open(Handle(fake.device, true), HidOpenFlags::async);
+	}
+
+	std::array<uint8_t, reportSize> makeReport(uint8_t fill)
+	{
+		std::array<uint8_t, reportSize> report {};
+		report.fill(fill);
+		report[0] = 0x01;
+		return report;
+	}
+
+	void testAsyncRead()
+	{
+		const std::string test = "async read";
+
+		FakeDevice fake = FakeDevice::socketPair();
+		HidInstance instance;
+
+		check(openFake(instance, fake), test, "open failed");
+		check(instance.isAsync(), test, "instance is not async");
+
+		// as with an overlapped ReadFile, readAsync succeeds when the read is issued, not when it completes
+		check(instance.readAsync(), test, "readAsync failed");
+		check(instance.asyncReadPending(), test, "no read pending");
+		check(instance.asyncReadInProgress(), test, "read completed with no report available");
+
+		HidInstance* const instances[] = { &instance };
+		check(!HidInstance::waitForAnyAsyncRead(instances, 10), test, "waitForAnyAsyncRead did not time out");
+		check(!instance.waitForAsyncRead(10), test, "waitForAsyncRead did not time out");
+
+		const auto report = makeReport(0xAB);
+		fake.send(report);
+
+		check(HidInstance::waitForAnyAsyncRead(instances, 1000), test, "waitForAnyAsyncRead timed out with a report available");
+		check(instance.waitForAsyncRead(0), test, "waitForAsyncRead timed out with a report available");
+		check(!instance.asyncReadInProgress(), test, "read did not complete");
+		check(std::ranges::equal(instance.inputBuffer, report), test, "inputBuffer does not hold the report");
+		check(instance.isOpen(), test, "instance closed after a completed read");
+
+		// with a report already queued, a new read completes immediately but is still reported as a completed read
+		const auto next = makeReport(0xCD);
+		fake.send(next);
+
+		check(instance.readAsync(), test, "readAsync failed with a report available");
+		check(instance.asyncReadPending(), test, "immediately completed read is not reported");
+		check(HidInstance::waitForAnyAsyncRead(instances, 0), test, "waitForAnyAsyncRead blocked on a completed read");
+		check(instance.waitForAsyncRead(0), test, "waitForAsyncRead blocked on a completed read");
+		check(!instance.asyncReadInProgress(), test, "immediately completed read still in progress");
+		check(!instance.asyncReadPending(), test, "read still pending after completion was reported");
+		check(std::ranges::equal(instance.inputBuffer, next), test, "inputBuffer does not hold the second report");
+	}
+
+	void testShortRead()
+	{
+		const std::string test = "short read";
+
+		FakeDevice fake = FakeDevice::socketPair();
+		HidInstance instance;
+
+		check(openFake(instance, fake), test, "open failed");
+
+		const auto report = makeReport(0xFF);
+		fake.send(report);
+		check(instance.readAsync() && !instance.asyncReadInProgress(), test, "full report did not complete");
+
+		// e.g. the short 0x01 report a Bluetooth DS4 sends before it is switched to 0x11 reports
+		constexpr std::array<uint8_t, 10> shortReport { 0x01, 0x7F, 0x80, 0x7F, 0x80, 0x08, 0x00, 0x00, 0x00, 0x00 };
+
+		check(instance.readAsync() && instance.asyncReadPending(), test, "no read pending");
+		fake.send(shortReport);
+		check(instance.waitForAsyncRead(1000), test, "waitForAsyncRead timed out with a report available");
+		check(!instance.asyncReadInProgress(), test, "short read did not complete");
+		check(instance.isOpen(), test, "instance closed after a short read");
+
+		const std::span<const uint8_t> buffer(instance.inputBuffer);
+
+		check(std::ranges::equal(buffer.first(shortReport.size()), shortReport), test, "inputBuffer does not begin with the short report");
+		check(std::ranges::all_of(buffer.subspan(shortReport.size()), [](uint8_t b) { return b == 0; }), test,
+		      "inputBuffer holds the end of the previous report past the short report");
+	}
+
+	void testDisconnect(FakeDevice (*makeDevice)(), const std::string& test)
+	{
+		FakeDevice fake = makeDevice();
+		HidInstance instance;
+
+		check(openFake(instance, fake), test, "open failed");
+		check(instance.readAsync() && instance.asyncReadPending(), test, "no read pending");
+
+		fake.closePeer();
+
+		HidInstance* const instances[] = { &instance };
+		check(HidInstance::waitForAnyAsyncRead(instances, 1000), test, "waitForAnyAsyncRead did not wake on disconnect");
+		check(!instance.asyncReadInProgress(), test, "read still in progress after disconnect");
+		check(!instance.isOpen(), test, "instance still open after disconnect");
+		check(instance.nativeError() == ENODEV, test, "nativeError is not ENODEV");
+		check(!instance.asyncReadPending(), test, "read still pending after disconnect");
+		check(!instance.readAsync(), test, "readAsync succeeded after disconnect");
+		check(HidInstance::waitForAnyAsyncRead(instances, 0), test, "waitForAnyAsyncRead blocked on a closed instance");
+	}
+
+	void testDisconnectBeforeRead()
+	{
+		const std::string test = "disconnect before read";
+
+		FakeDevice fake = FakeDevice::socketPair();
+		HidInstance instance;
+
+		check(openFake(instance, fake), test, "open failed");
+
+		fake.closePeer();
+
+		check(!instance.readAsync(), test, "readAsync succeeded at end of file");
+		check(!instance.asyncReadPending(), test, "read pending at end of file");
+		check(instance.nativeError() == ENODEV, test, "nativeError is not ENODEV");
+	}
+}
+
+/**
+ * \brief Exercises the hidraw backend of \c HidInstance against a socketpair or pipe standing in for the device node.
+ */
+int main()
+{
+	testAsyncRead();
+	testShortRead();
+	testDisconnect(&FakeDevice::socketPair, "disconnect (end of file)");
+	testDisconnect(&FakeDevice::pipe, "disconnect (hangup)");
+	testDisconnectBeforeRead();
+
+	if (failures == 0)
+	{
+		std::cout << "all hidraw backend tests passed" << std::endl;
+	}
+
+	return failures == 0 ? 0 : 1;
+}
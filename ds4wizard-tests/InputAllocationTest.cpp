@@ -0,0 +1,125 @@
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "CompiledProfile.h"
+#include "Ds4Benchmark.h"
+#include "Ds4Input.h"
+#include "Ds4Output.h"
+#include "Event.h"
+#include "InputSimulator.h"
+#include "TickClock.h"
+
+using namespace std::chrono;
+
+namespace
+{
+	struct EventSender
+	{
+	};
+
+	/**
+	 * \brief Raises an event with listeners registered, as a device does with each report,
+	 * and fails if raising it allocates.
+	 */
+	int testEvent()
+	{
+		Event<EventSender, int> event;
+		EventSender sender;
+
+		int calls = 0;
+
+		const EventToken first  = event.add([&](EventSender*, int) { ++calls; });
+		const EventToken second = event.add([&](EventSender*, int) { ++calls; });
+
+		event.invoke(&sender, 0);
+
+		const uint64_t firstAllocation = Ds4Benchmark::allocationCount();
+
+		for (int i = 0; i < 1'000; ++i)
+		{
+			event.invoke(&sender, i);
+		}
+
+		const uint64_t allocations = Ds4Benchmark::allocationCount() - firstAllocation;
+
+		if (allocations != 0 || calls != 2'002)
+		{
+			std::cerr << "Event::invoke: " << allocations << " allocations in 1000 invocations" << std::endl;
+			return 1;
+		}
+
+		std::cout << "Event::invoke: no allocations" << std::endl;
+		return 0;
+	}
+}
+
+/**
+ * \brief Feeds generated input reports through \c Ds4Input::update and \c InputSimulator::runMaps,
+ * as a connected device would, and fails if any report after warm-up allocates or if raising an event allocates.
+ * Requires \c DS4W_COUNT_ALLOCATIONS. \sa Ds4Benchmark::allocationCount
+ */
+int main()
+{
+	if (!Ds4Benchmark::countsAllocations())
+	{
+		std::cerr << "allocation counting is not compiled in" << std::endl;
+		return 1;
+	}
+
+	constexpr size_t warmupCount = 1'000;
+	constexpr size_t reportCount = 3'000;
+
+	const std::vector<Ds4CaptureRecord> records = Ds4Benchmark::makeReports(reportCount);
+
+	int failures = testEvent();
+
+	for (const Ds4BenchmarkScenario& scenario : Ds4Benchmark::defaultScenarios())
+	{
+		VirtualClock clock;
+		const TickClock::ScopedSource source(clock);
+
+		Ds4Input input {};
+		Ds4Output output {};
+		Ds4BenchmarkSinks sinks;
+
+		InputSimulator simulator(input, output, sinks.sinks());
+		simulator.applyProfile(std::make_unique<CompiledProfile>(Ds4Benchmark::makeProfile(scenario), &simulator));
+		simulator.start();
+
+		uint64_t firstAllocation = 0;
+
+		for (size_t i = 0; i < records.size(); ++i)
+		{
+			if (i == warmupCount)
+			{
+				firstAllocation = Ds4Benchmark::allocationCount();
+			}
+
+			const Ds4CaptureRecord& record = records[i];
+			clock.set(Stopwatch::TimePoint(duration_cast<Stopwatch::Duration>(nanoseconds(record.timestamp))));
+
+			const TickClock::Tick tick;
+
+			// generated reports are USB reports, so the input data follows the report ID
+			input.update(record.data().subspan(1));
+			simulator.runMaps();
+		}
+
+		const uint64_t allocations = Ds4Benchmark::allocationCount() - firstAllocation;
+
+		if (allocations != 0)
+		{
+			std::cerr << scenario.name << ": " << allocations << " allocations in "
+			          << (reportCount - warmupCount) << " reports after warm-up" << std::endl;
+			++failures;
+		}
+		else
+		{
+			std::cout << scenario.name << ": no allocations after warm-up (" << sinks.events << " outputs)" << std::endl;
+		}
+	}
+
+	return failures == 0 ? 0 : 1;
+}
@@ -1,13 +1,17 @@
 #include "hid_handle.h"
 #include <utility>
 
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
 Handle::Handle(Handle&& other) noexcept
 	: owner(std::exchange(other.owner, false)),
-	  nativeHandle(std::exchange(other.nativeHandle, INVALID_HANDLE_VALUE))
+	  nativeHandle(std::exchange(other.nativeHandle, invalidHandle()))
 {
 }
 
-Handle::Handle(HANDLE h, bool owner)
+Handle::Handle(NativeHandle h, bool owner)
 	: owner(owner),
 	  nativeHandle(h)
 {
@@ -20,15 +24,23 @@ Handle::~Handle()
 
 bool Handle::isValid() const
 {
+#ifdef _WIN32
 	return nativeHandle && nativeHandle != INVALID_HANDLE_VALUE;
+#else
+	return nativeHandle >= 0;
+#endif
 }
 
 void Handle::close()
 {
 	if (owner && isValid())
 	{
+#ifdef _WIN32
 		CloseHandle(nativeHandle);
-		nativeHandle = INVALID_HANDLE_VALUE;
+#else
+		::close(nativeHandle);
+#endif
+		nativeHandle = invalidHandle();
 	}
 }
 
@@ -49,8 +61,17 @@ Handle& Handle::operator=(Handle&& rhs) noexcept
 		close();
 
 		owner        = std::exchange(rhs.owner, false);
-		nativeHandle = std::exchange(rhs.nativeHandle, INVALID_HANDLE_VALUE);
+		nativeHandle = std::exchange(rhs.nativeHandle, invalidHandle());
 	}
 
 	return *this;
 }
+
+Handle::NativeHandle Handle::invalidHandle()
+{
+#ifdef _WIN32
+	return INVALID_HANDLE_VALUE;
+#else
+	return -1;
+#endif
+}
@@ -1,18 +1,26 @@
 #pragma once
 
+#ifdef _WIN32
 #include <Windows.h>
+#endif
 
 class Handle
 {
 public:
+#ifdef _WIN32
+	using NativeHandle = HANDLE;
+#else
+	using NativeHandle = int;
+#endif
+
 	bool owner = false;
-	HANDLE nativeHandle = INVALID_HANDLE_VALUE;
+	NativeHandle nativeHandle = invalidHandle();
 
 	Handle() = default;
 	Handle(const Handle& other) = delete;
 
 	Handle(Handle&& other) noexcept;
-	explicit Handle(HANDLE h, bool owner = false);
+	explicit Handle(NativeHandle h, bool owner = false);
 	~Handle();
 
 	[[nodiscard]] bool isValid() const;
@@ -24,4 +32,9 @@ public:
 
 	Handle& operator=(const Handle& rhs) = delete;
 	Handle& operator=(Handle&& rhs) noexcept;
+
+	/**
+	 * \brief The value of \c nativeHandle for an invalid handle on the current platform.
+	 */
+	static NativeHandle invalidHandle();
 };
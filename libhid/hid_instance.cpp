@@ -1,8 +1,12 @@
+#ifdef _WIN32
+
 #include <Windows.h>
 #include <hidsdi.h>
 #include <hidpi.h>
 
+#include <array>
 #include <utility>
+#include <vector>
 
 #include "hid_handle.h"
 #include "hid_instance.h"
@@ -27,6 +31,7 @@ HidInstance::HidInstance(HidInstance&& other) noexcept
 	  attributes_(other.attributes_),
 	  overlappedIn_(other.overlappedIn_),
 	  overlappedOut_(other.overlappedOut_),
+	  readEvent_(std::move(other.readEvent_)),
 	  pendingRead_(other.pendingRead_),
 	  pendingWrite_(other.pendingWrite_),
 	  path(std::move(other.path)),
@@ -56,6 +61,7 @@ HidInstance& HidInstance::operator=(HidInstance&& other) noexcept
 	outputBuffer = std::move(other.outputBuffer);
 	overlappedIn_ = other.overlappedIn_;
 	overlappedOut_ = other.overlappedOut_;
+	readEvent_ = std::move(other.readEvent_);
 	pendingRead_ = other.pendingRead_;
 	pendingWrite_ = other.pendingWrite_;
 
@@ -218,10 +224,32 @@ bool HidInstance::open(HidOpenFlags_t openFlags)
 
 	flags_ = openFlags;
 
-	if (isAsync())
+	if (isAsync() && !readEvent_.isValid())
+	{
+		readEvent_ = Handle(CreateEvent(nullptr, TRUE, FALSE, nullptr), true);
+	}
+
+	return true;
+}
+
+bool HidInstance::open(Handle nativeHandle, HidOpenFlags_t openFlags)
+{
+	close();
+
+	nativeError_ = ERROR_SUCCESS;
+
+	if (!nativeHandle.isValid())
 	{
-		//overlappedIn.hEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
-		//overlappedOut.hEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+		nativeError_ = ERROR_INVALID_HANDLE;
+		return false;
+	}
+
+	handle_ = std::move(nativeHandle);
+	flags_ = openFlags;
+
+	if (isAsync() && !readEvent_.isValid())
+	{
+		readEvent_ = Handle(CreateEvent(nullptr, TRUE, FALSE, nullptr), true);
 	}
 
 	return true;
@@ -234,9 +262,6 @@ void HidInstance::close()
 		cancelAsyncReadAndWait();
 		cancelAsyncWriteAndWait();
 
-		//CloseHandle(overlappedIn.hEvent);
-		//CloseHandle(overlappedOut.hEvent);
-
 		overlappedIn_ = {};
 		overlappedOut_ = {};
 
@@ -287,6 +312,8 @@ bool HidInstance::readAsync()
 		return !asyncReadInProgress();
 	}
 
+	overlappedIn_.hEvent = readEvent_.nativeHandle;
+
 	const bool result = !!ReadFile(handle_.nativeHandle,
 	                               inputBuffer.data(),
 	                               static_cast<DWORD>(inputBuffer.size()),
@@ -297,16 +324,17 @@ bool HidInstance::readAsync()
 	{
 		const DWORD error = GetLastError();
 
-		if (error == ERROR_IO_PENDING)
+		if (error != ERROR_IO_PENDING)
 		{
-			pendingRead_ = true;
-			return true;
+			nativeError_ = error;
+			return false;
 		}
-
-		nativeError_ = error;
 	}
 
-	return result;
+	// A read which completed immediately still sets readEvent_
+	// and is reported by asyncReadInProgress like any other.
+	pendingRead_ = true;
+	return true;
 }
 
 bool HidInstance::write(const void* buffer, size_t size)
@@ -382,6 +410,41 @@ bool HidInstance::asyncReadInProgress()
 	return pendingRead_;
 }
 
+bool HidInstance::waitForAsyncRead(uint32_t timeoutMilliseconds)
+{
+	if (!pendingRead_ || !readEvent_.isValid())
+	{
+		return true;
+	}
+
+	return WaitForSingleObject(readEvent_.nativeHandle, timeoutMilliseconds) == WAIT_OBJECT_0;
+}
+
+bool HidInstance::waitForAnyAsyncRead(std::span<HidInstance* const> instances, uint32_t timeoutMilliseconds)
+{
+	if (instances.empty() || instances.size() > maxWaitCount)
+	{
+		return true;
+	}
+
+	std::array<HANDLE, maxWaitCount> events {};
+
+	for (size_t i = 0; i < instances.size(); ++i)
+	{
+		const HidInstance* instance = instances[i];
+
+		if (!instance->pendingRead_ || !instance->readEvent_.isValid())
+		{
+			return true;
+		}
+
+		events[i] = instance->readEvent_.nativeHandle;
+	}
+
+	const DWORD result = WaitForMultipleObjects(static_cast<DWORD>(instances.size()), events.data(), FALSE, timeoutMilliseconds);
+	return result < WAIT_OBJECT_0 + instances.size();
+}
+
 bool HidInstance::asyncWritePending() const
 {
 	return pendingWrite_;
@@ -507,7 +570,7 @@ bool HidInstance::asyncInProgress(OVERLAPPED* overlapped)
 	}
 }
 
-bool HidInstance::readCaps(HANDLE h)
+bool HidInstance::readCaps(Handle::NativeHandle h)
 {
 	bool result;
 
@@ -557,7 +620,7 @@ bool HidInstance::readCaps(HANDLE h)
 	return result;
 }
 
-bool HidInstance::readSerial(HANDLE h)
+bool HidInstance::readSerial(Handle::NativeHandle h)
 {
 	nativeError_ = ERROR_SUCCESS;
 
@@ -581,7 +644,7 @@ bool HidInstance::readSerial(HANDLE h)
 	return result;
 }
 
-bool HidInstance::readAttributes(HANDLE h)
+bool HidInstance::readAttributes(Handle::NativeHandle h)
 {
 	nativeError_ = ERROR_SUCCESS;
 
@@ -599,3 +662,5 @@ bool HidInstance::readAttributes(HANDLE h)
 
 	return result;
 }
+
+#endif
@@ -1,6 +1,8 @@
 #pragma once
 
+#ifdef _WIN32
 #include <Windows.h>
+#endif
 
 #include <cstdint>
 #include <span>
@@ -53,18 +55,32 @@ namespace hid
 	{
 		HidOpenFlags_t flags_ = HidOpenFlags::none;
 
-		Handle handle_ = Handle(nullptr, true);
+		Handle handle_ = Handle(Handle::invalidHandle(), true);
 
 		HidCaps caps_ {};
 		HidAttributes attributes_ {};
 
+#ifdef _WIN32
 		OVERLAPPED overlappedIn_ = {};
 		OVERLAPPED overlappedOut_ = {};
 
+		// Manual-reset event set when a read into overlappedIn_ completes, which is what
+		// waitForAsyncRead and waitForAnyAsyncRead block on. It is kept open across close().
+		Handle readEvent_ = Handle(Handle::invalidHandle(), true);
+#else
+		// epoll instance watching handle_ for whichever of EPOLLIN and EPOLLOUT has an operation pending.
+		// It is readable itself while either is ready, so it can be passed to poll by waitForAnyAsyncRead.
+		Handle epoll_ = Handle(Handle::invalidHandle(), true);
+
+		// Set when readAsync completes without waiting, so that the report in inputBuffer is
+		// still reported as a completed read by the next asyncReadInProgress, as on Windows.
+		bool readCompleted_ = false;
+#endif
+
 		bool pendingRead_ = false;
 		bool pendingWrite_ = false;
 
-		size_t nativeError_ = ERROR_SUCCESS;
+		size_t nativeError_ = 0;
 
 	public:
 		std::wstring path;
@@ -101,6 +117,16 @@ namespace hid
 		bool setFeature(std::span<uint8_t> buffer);
 
 		bool open(HidOpenFlags_t openFlags);
+
+		/**
+		 * \brief Opens this instance over an already-open native handle instead of \c path.
+		 * On Linux, this allows a socketpair or pipe to stand in for a hidraw node.
+		 * \param nativeHandle The handle to take ownership of.
+		 * \param openFlags Flags describing how \p nativeHandle was opened.
+		 * \return \c true if \p nativeHandle is valid.
+		 */
+		bool open(Handle nativeHandle, HidOpenFlags_t openFlags);
+
 		void close();
 
 		[[nodiscard]] inline auto nativeError() const
@@ -112,6 +138,11 @@ namespace hid
 		bool read(std::span<uint8_t> buffer);
 		bool read();
 
+		/**
+		 * \brief Issues an asynchronous read into \c inputBuffer. A read which completes immediately
+		 * is still pending until \c asyncReadInProgress reports it, the same as one which completes later.
+		 * \return \c true if the read was issued or, if one was already pending, has completed.
+		 */
 		bool readAsync();
 
 		bool write(const void* buffer, size_t size);
@@ -122,6 +153,34 @@ namespace hid
 
 		bool asyncReadPending() const;
 		bool asyncReadInProgress();
+
+		/**
+		 * \brief Blocks until a pending asynchronous read is ready to be completed by
+		 * \c asyncReadInProgress, or until \p timeoutMilliseconds elapses.
+		 * \param timeoutMilliseconds The maximum amount of time to wait.
+		 * \return \c true if the read is ready or no read is pending.
+		 */
+		bool waitForAsyncRead(uint32_t timeoutMilliseconds);
+
+		/**
+		 * \brief The most instances \c waitForAnyAsyncRead can block on at once.
+		 */
+#ifdef _WIN32
+		static constexpr size_t maxWaitCount = MAXIMUM_WAIT_OBJECTS;
+#else
+		static constexpr size_t maxWaitCount = 64;
+#endif
+
+		/**
+		 * \brief Blocks until a pending asynchronous read on any of \p instances is ready to be
+		 * completed by \c asyncReadInProgress, or until \p timeoutMilliseconds elapses.
+		 * \param instances The instances to wait on. If there are more than \c maxWaitCount, none are waited on.
+		 * \param timeoutMilliseconds The maximum amount of time to wait.
+		 * \return \c true if any read is ready, any instance has no read pending, or there are too many to wait on.
+		 * \sa waitForAsyncRead
+		 */
+		static bool waitForAnyAsyncRead(std::span<HidInstance* const> instances, uint32_t timeoutMilliseconds);
+
 		bool asyncWritePending() const;
 		bool asyncWriteInProgress();
 
@@ -132,11 +191,19 @@ namespace hid
 		bool setOutputReport();
 
 	private:
+#ifdef _WIN32
 		void cancelAsyncAndWait(OVERLAPPED* overlapped);
 		bool asyncInProgress(OVERLAPPED* overlapped);
-
-		bool readCaps(HANDLE h);
-		bool readSerial(HANDLE h);
-		bool readAttributes(HANDLE h);
+#else
+		bool updateWatch();
+		uint32_t poll(int timeoutMilliseconds);
+		bool completeRead();
+		bool completeWrite();
+		bool asyncInProgress(uint32_t event);
+#endif
+
+		bool readCaps(Handle::NativeHandle h);
+		bool readSerial(Handle::NativeHandle h);
+		bool readAttributes(Handle::NativeHandle h);
 	};
 }
@@ -0,0 +1,931 @@
+#ifdef __linux__
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/file.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <linux/hidraw.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "hid_handle.h"
+#include "hid_instance.h"
+
+using namespace hid;
+
+namespace
+{
+	std::string narrow(const std::wstring& str)
+	{
+		// hidraw paths are plain ASCII (/dev/hidrawN)
+		std::string result;
+		result.reserve(str.size());
+
+		for (const wchar_t c : str)
+		{
+			result.push_back(static_cast<char>(c));
+		}
+
+		return result;
+	}
+
+	bool wouldBlock(int error)
+	{
+		return error == EAGAIN || error == EWOULDBLOCK || error == EINTR;
+	}
+
+	/**
+	 * \brief Waits on a blocking-style operation for a non-blocking descriptor.
+	 * \param fd The descriptor to wait on.
+	 * \param events \c POLLIN or \c POLLOUT
+	 */
+	void waitFor(int fd, short events)
+	{
+		pollfd pfd {};
+		pfd.fd = fd;
+		pfd.events = events;
+		::poll(&pfd, 1, -1);
+	}
+
+	/**
+	 * \brief Zeroes whatever \p buffer holds past the \p received bytes of a report read into it.
+	 * Windows pads every input report to the length of the longest one; hidraw returns each
+	 * report at its own length, which would otherwise leave the end of the previous report behind.
+	 */
+	void clearShortRead(void* buffer, size_t size, ssize_t received)
+	{
+		if (received > 0 && static_cast<size_t>(received) < size)
+		{
+			std::fill_n(static_cast<uint8_t*>(buffer) + received, size - static_cast<size_t>(received), 0);
+		}
+	}
+
+	/**
+	 * \brief Walks a HID report descriptor and fills in the report sizes and top-level usage.
+	 * Report sizes include the report ID byte to match what Windows reports in \c HIDP_CAPS.
+	 * The remaining counts (button caps, value caps, data indices) are not derivable
+	 * without a full HID parser and are left as zero.
+	 */
+	void parseReportDescriptor(std::span<const uint8_t> descriptor, HidCaps& caps)
+	{
+		enum ReportType { input, output, feature, reportTypeCount };
+
+		struct GlobalState
+		{
+			uint32_t usagePage   = 0;
+			uint32_t reportSize  = 0;
+			uint32_t reportCount = 0;
+			uint32_t reportId    = 0;
+		};
+
+		GlobalState global {};
+		std::vector<GlobalState> globalStack;
+		std::array<std::map<uint32_t, uint32_t>, reportTypeCount> reportBits {};
+
+		uint32_t usage = 0;
+		bool haveTopLevelUsage = false;
+
+		size_t i = 0;
+
+		while (i < descriptor.size())
+		{
+			const uint8_t prefix = descriptor[i];
+
+			// long items; nothing in them we care about
+			if (prefix == 0xFE)
+			{
+				if (i + 1 >= descriptor.size())
+				{
+					break;
+				}
+
+				i += 3 + descriptor[i + 1];
+				continue;
+			}
+
+			const size_t dataSize = (prefix & 0x03) == 3 ? 4 : (prefix & 0x03);
+			const uint8_t type = (prefix >> 2) & 0x03;
+			const uint8_t tag  = (prefix >> 4) & 0x0F;
+
+			if (i + 1 + dataSize > descriptor.size())
+			{
+				break;
+			}
+
+			uint32_t value = 0;
+
+			for (size_t k = 0; k < dataSize; ++k)
+			{
+				value |= static_cast<uint32_t>(descriptor[i + 1 + k]) << (8 * k);
+			}
+
+			i += 1 + dataSize;
+
+			switch (type)
+			{
+				case 0: // main
+					switch (tag)
+					{
+						case 0x8:
+							reportBits[input][global.reportId] += global.reportSize * global.reportCount;
+							break;
+
+						case 0x9:
+							reportBits[output][global.reportId] += global.reportSize * global.reportCount;
+							break;
+
+						case 0xB:
+							reportBits[feature][global.reportId] += global.reportSize * global.reportCount;
+							break;
+
+						case 0xA: // collection
+							if (!haveTopLevelUsage && value == 0x01) // application
+							{
+								caps.usagePage = static_cast<uint16_t>(global.usagePage);
+								caps.usage     = static_cast<uint16_t>(usage);
+								haveTopLevelUsage = true;
+							}
+
+							break;
+
+						default:
+							break;
+					}
+
+					usage = 0;
+					break;
+
+				case 1: // global
+					switch (tag)
+					{
+						case 0x0:
+							global.usagePage = value;
+							break;
+
+						case 0x7:
+							global.reportSize = value;
+							break;
+
+						case 0x8:
+							global.reportId = value;
+							break;
+
+						case 0x9:
+							global.reportCount = value;
+							break;
+
+						case 0xA:
+							globalStack.push_back(global);
+							break;
+
+						case 0xB:
+							if (!globalStack.empty())
+							{
+								global = globalStack.back();
+								globalStack.pop_back();
+							}
+
+							break;
+
+						default:
+							break;
+					}
+
+					break;
+
+				case 2: // local
+					if (tag == 0x0 && !usage)
+					{
+						usage = value & 0xFFFF;
+					}
+
+					break;
+
+				default:
+					break;
+			}
+		}
+
+		auto largestReport = [&](ReportType reportType) -> uint16_t
+		{
+			uint32_t result = 0;
+
+			for (const auto& pair : reportBits[reportType])
+			{
+				result = std::max(result, (pair.second + 7) / 8 + 1);
+			}
+
+			return static_cast<uint16_t>(result);
+		};
+
+		caps.inputReportSize   = largestReport(input);
+		caps.outputReportSize  = largestReport(output);
+		caps.featureReportSize = largestReport(feature);
+	}
+}
+
+HidInstance::HidInstance(std::wstring path, std::wstring instanceId)
+	: path(std::move(path)),
+	  instanceId(std::move(instanceId))
+{
+}
+
+HidInstance::HidInstance(std::wstring path)
+	: path(std::move(path))
+{
+}
+
+HidInstance::HidInstance(HidInstance&& other) noexcept
+	: flags_(std::exchange(other.flags_, HidOpenFlags::none)),
+	  handle_(std::move(other.handle_)),
+	  caps_(other.caps_),
+	  attributes_(other.attributes_),
+	  epoll_(std::move(other.epoll_)),
+	  pendingRead_(std::exchange(other.pendingRead_, false)),
+	  pendingWrite_(std::exchange(other.pendingWrite_, false)),
+	  path(std::move(other.path)),
+	  instanceId(std::move(other.instanceId)),
+	  serialString(std::move(other.serialString)),
+	  inputBuffer(std::move(other.inputBuffer)),
+	  outputBuffer(std::move(other.outputBuffer))
+{
+}
+
+HidInstance::~HidInstance()
+{
+	close();
+}
+
+HidInstance& HidInstance::operator=(HidInstance&& other) noexcept
+{
+	handle_ = std::move(other.handle_);
+	epoll_ = std::move(other.epoll_);
+	flags_ = std::exchange(other.flags_, HidOpenFlags::none);
+	caps_ = other.caps_;
+	attributes_ = other.attributes_;
+	serialString = std::move(other.serialString);
+	path = std::move(other.path);
+	instanceId = std::move(other.instanceId);
+
+	inputBuffer = std::move(other.inputBuffer);
+	outputBuffer = std::move(other.outputBuffer);
+	pendingRead_ = std::exchange(other.pendingRead_, false);
+	pendingWrite_ = std::exchange(other.pendingWrite_, false);
+
+	return *this;
+}
+
+bool HidInstance::isOpen() const
+{
+	return handle_.isValid();
+}
+
+bool HidInstance::isExclusive() const
+{
+	return !!(flags_ & HidOpenFlags::exclusive);
+}
+
+bool HidInstance::isAsync() const
+{
+	return !!(flags_ & HidOpenFlags::async);
+}
+
+const HidCaps& HidInstance::caps() const
+{
+	return caps_;
+}
+
+const HidAttributes& HidInstance::attributes() const
+{
+	return attributes_;
+}
+
+bool HidInstance::readMetadata()
+{
+	if (isOpen())
+	{
+		return (readCaps() | readAttributes() | readSerial());
+	}
+
+	nativeError_ = 0;
+
+	const Handle h = Handle(::open(narrow(path).c_str(), O_RDONLY | O_CLOEXEC), true);
+
+	if (!h.isValid())
+	{
+		nativeError_ = errno;
+		return false;
+	}
+
+	return (readCaps(h.nativeHandle) | readAttributes(h.nativeHandle) | readSerial(h.nativeHandle));
+}
+
+bool HidInstance::readCaps()
+{
+	return readCaps(handle_.nativeHandle);
+}
+
+bool HidInstance::readSerial()
+{
+	return readSerial(handle_.nativeHandle);
+}
+
+bool HidInstance::readAttributes()
+{
+	return readAttributes(handle_.nativeHandle);
+}
+
+bool HidInstance::getFeature(std::span<uint8_t> buffer)
+{
+	nativeError_ = 0;
+	bool result;
+
+	if (isOpen())
+	{
+		result = ioctl(handle_.nativeHandle, HIDIOCGFEATURE(buffer.size_bytes()), buffer.data()) >= 0;
+	}
+	else
+	{
+		const Handle h = Handle(::open(narrow(path).c_str(), O_RDWR | O_CLOEXEC), true);
+		result = h.isValid() && ioctl(h.nativeHandle, HIDIOCGFEATURE(buffer.size_bytes()), buffer.data()) >= 0;
+	}
+
+	if (!result)
+	{
+		nativeError_ = errno;
+	}
+
+	return result;
+}
+
+bool HidInstance::setFeature(std::span<uint8_t> buffer)
+{
+	if (!isOpen())
+	{
+		return false;
+	}
+
+	nativeError_ = 0;
+
+	const bool result = ioctl(handle_.nativeHandle, HIDIOCSFEATURE(buffer.size_bytes()), buffer.data()) >= 0;
+
+	if (!result)
+	{
+		nativeError_ = errno;
+	}
+
+	return result;
+}
+
+bool HidInstance::open(HidOpenFlags_t openFlags)
+{
+	close();
+
+	nativeError_ = 0;
+
+	const int asyncFlags = !!(openFlags & HidOpenFlags::async) ? O_NONBLOCK : 0;
+	Handle h = Handle(::open(narrow(path).c_str(), O_RDWR | O_CLOEXEC | asyncFlags), true);
+
+	if (!h.isValid())
+	{
+		nativeError_ = errno;
+		return false;
+	}
+
+	// hidraw has no share modes; exclusivity is only honored
+	// between processes which also lock the node.
+	if (!!(openFlags & HidOpenFlags::exclusive) && flock(h.nativeHandle, LOCK_EX | LOCK_NB) != 0)
+	{
+		nativeError_ = errno;
+		return false;
+	}
+
+	return open(std::move(h), openFlags);
+}
+
+bool HidInstance::open(Handle nativeHandle, HidOpenFlags_t openFlags)
+{
+	close();
+
+	nativeError_ = 0;
+
+	if (!nativeHandle.isValid())
+	{
+		nativeError_ = EBADF;
+		return false;
+	}
+
+	handle_ = std::move(nativeHandle);
+
+	if (!!(openFlags & HidOpenFlags::async))
+	{
+		const int fileFlags = fcntl(handle_.nativeHandle, F_GETFL);
+
+		if (fileFlags < 0 || fcntl(handle_.nativeHandle, F_SETFL, fileFlags | O_NONBLOCK) < 0)
+		{
+			nativeError_ = errno;
+			handle_.close();
+			return false;
+		}
+
+		if (!epoll_.isValid())
+		{
+			epoll_ = Handle(epoll_create1(EPOLL_CLOEXEC), true);
+		}
+
+		epoll_event event {};
+		event.data.fd = handle_.nativeHandle;
+
+		if (!epoll_.isValid() || epoll_ctl(epoll_.nativeHandle, EPOLL_CTL_ADD, handle_.nativeHandle, &event) != 0)
+		{
+			nativeError_ = errno;
+			handle_.close();
+			return false;
+		}
+	}
+
+	flags_ = openFlags;
+	return true;
+}
+
+void HidInstance::close()
+{
+	// Reads and writes are issued as non-blocking system calls,
+	// so there is never a kernel operation in flight to cancel.
+	pendingRead_ = false;
+	readCompleted_ = false;
+	pendingWrite_ = false;
+
+	if (isOpen())
+	{
+		if (epoll_.isValid())
+		{
+			epoll_ctl(epoll_.nativeHandle, EPOLL_CTL_DEL, handle_.nativeHandle, nullptr);
+		}
+
+		handle_.close();
+	}
+
+	flags_ = HidOpenFlags::none;
+}
+
+bool HidInstance::read(void* buffer, size_t size)
+{
+	if (!isOpen())
+	{
+		return false;
+	}
+
+	nativeError_ = 0;
+
+	while (true)
+	{
+		const ssize_t result = ::read(handle_.nativeHandle, buffer, size);
+
+		if (result > 0)
+		{
+			clearShortRead(buffer, size, result);
+			return true;
+		}
+
+		if (result < 0 && wouldBlock(errno))
+		{
+			waitFor(handle_.nativeHandle, POLLIN);
+			continue;
+		}
+
+		nativeError_ = result == 0 ? ENODEV : errno;
+		return false;
+	}
+}
+
+bool HidInstance::read(std::span<uint8_t> buffer)
+{
+	return read(buffer.data(), buffer.size());
+}
+
+bool HidInstance::read()
+{
+	return read(inputBuffer);
+}
+
+bool HidInstance::readAsync()
+{
+	if (pendingRead_)
+	{
+		return !asyncReadInProgress();
+	}
+
+	if (!isOpen())
+	{
+		return false;
+	}
+
+	const ssize_t result = ::read(handle_.nativeHandle, inputBuffer.data(), inputBuffer.size());
+
+	if (result > 0)
+	{
+		clearShortRead(inputBuffer.data(), inputBuffer.size(), result);
+		pendingRead_ = true;
+		readCompleted_ = true;
+		return true;
+	}
+
+	const int error = result == 0 ? ENODEV : errno;
+
+	if (wouldBlock(error))
+	{
+		pendingRead_ = true;
+		return updateWatch();
+	}
+
+	nativeError_ = error;
+	return false;
+}
+
+bool HidInstance::write(const void* buffer, size_t size)
+{
+	if (!isOpen())
+	{
+		return false;
+	}
+
+	nativeError_ = 0;
+
+	while (true)
+	{
+		const ssize_t result = ::write(handle_.nativeHandle, buffer, size);
+
+		if (result >= 0)
+		{
+			return true;
+		}
+
+		if (wouldBlock(errno))
+		{
+			waitFor(handle_.nativeHandle, POLLOUT);
+			continue;
+		}
+
+		nativeError_ = errno;
+		return false;
+	}
+}
+
+bool HidInstance::write(std::span<const uint8_t> buffer)
+{
+	return write(buffer.data(), buffer.size_bytes());
+}
+
+bool HidInstance::write()
+{
+	return write(outputBuffer);
+}
+
+bool HidInstance::writeAsync()
+{
+	if (pendingWrite_)
+	{
+		return asyncWriteInProgress();
+	}
+
+	if (!isOpen())
+	{
+		return false;
+	}
+
+	const ssize_t result = ::write(handle_.nativeHandle, outputBuffer.data(), outputBuffer.size());
+
+	if (result >= 0)
+	{
+		return true;
+	}
+
+	const int error = errno;
+
+	if (wouldBlock(error))
+	{
+		pendingWrite_ = true;
+		return updateWatch();
+	}
+
+	nativeError_ = error;
+	return false;
+}
+
+bool HidInstance::asyncReadPending() const
+{
+	return pendingRead_;
+}
+
+bool HidInstance::asyncReadInProgress()
+{
+	if (!pendingRead_)
+	{
+		return false;
+	}
+
+	if (readCompleted_)
+	{
+		readCompleted_ = false;
+		pendingRead_ = false;
+		return false;
+	}
+
+	pendingRead_ = asyncInProgress(EPOLLIN);
+	updateWatch();
+	return pendingRead_;
+}
+
+bool HidInstance::waitForAsyncRead(uint32_t timeoutMilliseconds)
+{
+	if (!pendingRead_ || readCompleted_ || !epoll_.isValid())
+	{
+		return true;
+	}
+
+	return (poll(static_cast<int>(timeoutMilliseconds)) & (EPOLLIN | EPOLLERR | EPOLLHUP)) != 0;
+}
+
+bool HidInstance::waitForAnyAsyncRead(std::span<HidInstance* const> instances, uint32_t timeoutMilliseconds)
+{
+	if (instances.empty() || instances.size() > maxWaitCount)
+	{
+		return true;
+	}
+
+	std::array<pollfd, maxWaitCount> fds {};
+
+	for (size_t i = 0; i < instances.size(); ++i)
+	{
+		const HidInstance* instance = instances[i];
+
+		if (!instance->pendingRead_ || instance->readCompleted_ || !instance->epoll_.isValid())
+		{
+			return true;
+		}
+
+		// An epoll instance is itself readable while any of its watched events are ready.
+		fds[i] = { instance->epoll_.nativeHandle, POLLIN, 0 };
+	}
+
+	return ::poll(fds.data(), instances.size(), static_cast<int>(timeoutMilliseconds)) > 0;
+}
+
+bool HidInstance::asyncWritePending() const
+{
+	return pendingWrite_;
+}
+
+bool HidInstance::asyncWriteInProgress()
+{
+	if (!pendingWrite_)
+	{
+		return false;
+	}
+
+	pendingWrite_ = asyncInProgress(EPOLLOUT);
+	updateWatch();
+	return pendingWrite_;
+}
+
+void HidInstance::cancelAsyncReadAndWait()
+{
+	if (!isOpen() || !isAsync() || !asyncReadPending())
+	{
+		return;
+	}
+
+	pendingRead_ = false;
+	updateWatch();
+}
+
+void HidInstance::cancelAsyncWriteAndWait()
+{
+	if (!isOpen() || !isAsync() || !asyncWritePending())
+	{
+		return;
+	}
+
+	pendingWrite_ = false;
+	updateWatch();
+}
+
+bool HidInstance::setOutputReport(std::span<uint8_t> buffer)
+{
+	if (!isOpen())
+	{
+		return false;
+	}
+
+	nativeError_ = 0;
+
+#ifdef HIDIOCSOUTPUT
+	if (ioctl(handle_.nativeHandle, HIDIOCSOUTPUT(buffer.size_bytes()), buffer.data()) >= 0)
+	{
+		return true;
+	}
+
+	// Kernels before 5.11 (and non-hidraw descriptors) don't support
+	// HIDIOCSOUTPUT; an interrupt write is the closest equivalent.
+	if (errno != ENOTTY && errno != EINVAL)
+	{
+		nativeError_ = errno;
+		return false;
+	}
+#endif
+
+	return write(buffer.data(), buffer.size_bytes());
+}
+
+bool HidInstance::setOutputReport()
+{
+	return setOutputReport(outputBuffer);
+}
+
+bool HidInstance::updateWatch()
+{
+	if (!isOpen() || !epoll_.isValid())
+	{
+		return false;
+	}
+
+	epoll_event event {};
+	event.events  = (pendingRead_ ? EPOLLIN : 0u) | (pendingWrite_ ? EPOLLOUT : 0u);
+	event.data.fd = handle_.nativeHandle;
+
+	if (epoll_ctl(epoll_.nativeHandle, EPOLL_CTL_MOD, handle_.nativeHandle, &event) != 0)
+	{
+		nativeError_ = errno;
+		return false;
+	}
+
+	return true;
+}
+
+uint32_t HidInstance::poll(int timeoutMilliseconds)
+{
+	epoll_event event {};
+
+	if (epoll_wait(epoll_.nativeHandle, &event, 1, timeoutMilliseconds) <= 0)
+	{
+		return 0;
+	}
+
+	return event.events;
+}
+
+bool HidInstance::completeRead()
+{
+	const ssize_t result = ::read(handle_.nativeHandle, inputBuffer.data(), inputBuffer.size());
+
+	if (result > 0)
+	{
+		clearShortRead(inputBuffer.data(), inputBuffer.size(), result);
+		return true;
+	}
+
+	const int error = result == 0 ? ENODEV : errno;
+
+	if (wouldBlock(error))
+	{
+		return false;
+	}
+
+	close();
+	nativeError_ = error;
+	return true;
+}
+
+bool HidInstance::completeWrite()
+{
+	const ssize_t result = ::write(handle_.nativeHandle, outputBuffer.data(), outputBuffer.size());
+
+	if (result >= 0)
+	{
+		return true;
+	}
+
+	const int error = errno;
+
+	if (wouldBlock(error))
+	{
+		return false;
+	}
+
+	close();
+	nativeError_ = error;
+	return true;
+}
+
+bool HidInstance::asyncInProgress(uint32_t event)
+{
+	if (!isOpen() || !isAsync())
+	{
+		return false;
+	}
+
+	const uint32_t events = poll(0);
+
+	if (events & event)
+	{
+		const bool completed = event == EPOLLIN ? completeRead() : completeWrite();
+		return !completed;
+	}
+
+	if (events & (EPOLLERR | EPOLLHUP))
+	{
+		close();
+		nativeError_ = ENODEV;
+		return false;
+	}
+
+	return true;
+}
+
+bool HidInstance::readCaps(Handle::NativeHandle h)
+{
+	nativeError_ = 0;
+
+	int descriptorSize = 0;
+
+	if (ioctl(h, HIDIOCGRDESCSIZE, &descriptorSize) < 0)
+	{
+		nativeError_ = errno;
+		return false;
+	}
+
+	hidraw_report_descriptor descriptor {};
+	descriptor.size = static_cast<uint32_t>(descriptorSize);
+
+	if (ioctl(h, HIDIOCGRDESC, &descriptor) < 0)
+	{
+		nativeError_ = errno;
+		return false;
+	}
+
+	caps_ = {};
+	parseReportDescriptor(std::span<const uint8_t>(descriptor.value, descriptor.size), caps_);
+
+	inputBuffer.resize(caps().inputReportSize);
+	outputBuffer.resize(caps().outputReportSize);
+
+	return true;
+}
+
+bool HidInstance::readSerial(Handle::NativeHandle h)
+{
+	nativeError_ = 0;
+
+	std::array<char, 256> buffer {};
+
+	if (ioctl(h, HIDIOCGRAWUNIQ(buffer.size()), buffer.data()) < 0)
+	{
+		nativeError_ = errno;
+		return false;
+	}
+
+	// The kernel formats Bluetooth addresses as aa:bb:cc:dd:ee:ff,
+	// whereas HidD_GetSerialNumberString reports aabbccddeeff.
+	serialString.clear();
+
+	for (size_t i = 0; i < buffer.size() && buffer[i] != '\0'; ++i)
+	{
+		if (buffer[i] != ':')
+		{
+			serialString.push_back(static_cast<wchar_t>(buffer[i]));
+		}
+	}
+
+	return true;
+}
+
+bool HidInstance::readAttributes(Handle::NativeHandle h)
+{
+	nativeError_ = 0;
+
+	hidraw_devinfo info {};
+	const bool result = ioctl(h, HIDIOCGRAWINFO, &info) >= 0;
+
+	// hidraw does not expose the device release number.
+	attributes_.vendorId = static_cast<uint16_t>(info.vendor);
+	attributes_.productId = static_cast<uint16_t>(info.product);
+	attributes_.versionNumber = 0;
+
+	if (!result)
+	{
+		nativeError_ = errno;
+	}
+
+	return result;
+}
+
+#endif
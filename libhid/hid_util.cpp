@@ -1,3 +1,5 @@
+#ifdef _WIN32
+
 #include <Windows.h>
 #include <initguid.h> // for GUID_DEVINTERFACE_USB_HUB
 #include <usbiodef.h>
@@ -145,3 +147,5 @@ void hid::enumerateUsb(const std::function<bool(const std::wstring& path, const
 {
 	enumerateGuid(fn, GUID_DEVINTERFACE_USB_HUB);
 }
+
+#endif
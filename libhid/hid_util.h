@@ -1,8 +1,10 @@
 #pragma once
 
+#ifdef _WIN32
 // Windows
 #include <Windows.h>
 #include <SetupAPI.h>
+#endif
 
 // STL
 #include <functional>
@@ -13,9 +15,13 @@
 
 namespace hid
 {
+#ifdef _WIN32
 	std::wstring getDevicePath(HDEVINFO devInfoSet, SP_DEVICE_INTERFACE_DATA* interface, SP_DEVINFO_DATA* data = nullptr) noexcept;
 	std::wstring getInstanceId(HDEVINFO devInfoSet, SP_DEVINFO_DATA* devInfoData) noexcept;
 	bool enumerateGuid(const std::function<bool(const std::wstring& path, const std::wstring& instanceId)>& fn, const GUID& guid) noexcept;
+#endif
 	void enumerateHid(const std::function<bool(std::shared_ptr<HidInstance> instance)>& fn) noexcept;
+#ifdef _WIN32
 	void enumerateUsb(const std::function<bool(const std::wstring& path, const std::wstring& instanceId)>& fn) noexcept;
+#endif
 }
@@ -0,0 +1,44 @@
+#ifdef __linux__
+
+#include <filesystem>
+#include <functional>
+#include <string>
+
+#include "hid_instance.h"
+#include "hid_util.h"
+
+namespace fs = std::filesystem;
+
+namespace
+{
+	std::wstring widen(const std::string& str)
+	{
+		return std::wstring(str.begin(), str.end());
+	}
+}
+
+void hid::enumerateHid(const std::function<bool(std::shared_ptr<HidInstance> instance)>& fn) noexcept
+{
+	std::error_code error;
+	fs::directory_iterator it("/sys/class/hidraw", error);
+
+	for (; !error && it != fs::directory_iterator(); it.increment(error))
+	{
+		const fs::path name = it->path().filename();
+
+		// The sysfs device link is the closest equivalent to a Windows device instance ID;
+		// it stays the same for every interface of a physical device.
+		std::error_code linkError;
+		const fs::path instancePath = fs::canonical(it->path() / "device", linkError);
+
+		auto hid = std::make_shared<HidInstance>(widen((fs::path("/dev") / name).string()),
+		                                         widen(linkError ? std::string() : instancePath.string()));
+
+		if (hid->readMetadata() && fn(hid))
+		{
+			break;
+		}
+	}
+}
+
+#endif